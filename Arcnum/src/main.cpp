@@ -1,8 +1,13 @@
 ﻿#include "spark_ecs.hpp"
+#include "spark_threading.hpp"
 #include <iostream>
 #include <chrono>
 #include <vector>
 #include <random>
+#include <mutex>
+#include <queue>
+#include <span>
+#include <thread>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -14,8 +19,20 @@ size_t getProcessMemory() {
     }
     return 0;
 }
+#elif defined(__linux__)
+#include <fstream>
+#include <unistd.h>
+// Resident set size from /proc/self/statm (second field, in pages)
+size_t getProcessMemory() {
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0, resident_pages = 0;
+    if (!(statm >> total_pages >> resident_pages)) {
+        return 0;
+    }
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
 #else
-// Fallback for non-Windows: returns 0 (memory measurement unsupported)
+// Fallback for other platforms: returns 0 (memory measurement unsupported)
 size_t getProcessMemory() {
     return 0;
 }
@@ -135,7 +152,7 @@ BenchResult benchmarkComponentAccess(size_t accesses) {
     }
     auto start = std::chrono::high_resolution_clock::now();
     for (size_t i = 0; i < accesses; ++i) {
-        auto& ent = entities[createCount - (i / 10)];
+        auto& ent = entities[createCount - 1 - (i / 10)];
         coord.GetComponent<Position>(ent).x += 1;
 
     }
@@ -146,6 +163,27 @@ BenchResult benchmarkComponentAccess(size_t accesses) {
     return { std::chrono::duration<double>(elapsed).count(), accesses, 0 };
 }
 
+// Benchmark: Random component access through a cached ComponentLookup
+BenchResult benchmarkComponentLookup(size_t accesses) {
+    spark::Coordinator coord;
+    std::vector<spark::Entity> entities;
+    size_t createCount = accesses / 10;
+    for (size_t i = 0; i < createCount; ++i) {
+        entities.push_back(coord.CreateEntity(Position{ 0,0,0,0 }, Velocity{ 0,0,0,0 }, Health{ 100,0,0,0 }));
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    auto positions = coord.GetLookup<Position>();
+    for (size_t i = 0; i < accesses; ++i) {
+        auto& ent = entities[createCount - 1 - (i / 10)];
+        positions[ent].x += 1;
+    }
+
+    std::cout << positions[entities[0]].x << std::endl;
+
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    return { std::chrono::duration<double>(elapsed).count(), accesses, 0 };
+}
+
 // Benchmark: Mixed operations
 BenchResult runMixedOperationsBenchmark() {
     const size_t OPERATIONS = 1'000'000;
@@ -183,6 +221,131 @@ BenchResult runMixedOperationsBenchmark() {
     return { std::chrono::duration<double>(elapsed).count(), OPERATIONS, getProcessMemory() - startMem };
 }
 
+// The mutex-guarded std::queue the lock-free queues replace, behind the same interface
+template <typename T>
+class MutexQueue {
+public:
+    explicit MutexQueue(size_t) {}
+
+    bool TryPush(T item) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push(std::move(item));
+        return true;
+    }
+
+    size_t TryPushBatch(std::span<T> items) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (T& item : items) {
+            m_queue.push(std::move(item));
+        }
+        return items.size();
+    }
+
+    bool TryPop(T& out) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.empty()) {
+            return false;
+        }
+        out = std::move(m_queue.front());
+        m_queue.pop();
+        return true;
+    }
+
+    size_t TryPopBatch(std::span<T> out) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t count = 0;
+        for (; count < out.size() && !m_queue.empty(); ++count) {
+            out[count] = std::move(m_queue.front());
+            m_queue.pop();
+        }
+        return count;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::queue<T> m_queue;
+};
+
+// Benchmark: `items` values pushed by `producers` threads and popped by `consumers`,
+// `batch` at a time (1 uses the single-item calls)
+template <typename Queue>
+BenchResult benchmarkQueue(size_t producers, size_t consumers, size_t items, size_t batch) {
+    constexpr size_t CAPACITY = 1024;
+    Queue queue(CAPACITY);
+    const size_t per_producer = items / producers;
+    const size_t total = per_producer * producers;
+    std::atomic<size_t> consumed{ 0 };
+    std::atomic<uint64_t> checksum{ 0 };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&]() {
+            std::vector<uint64_t> buffer(batch);
+            for (size_t i = 0; i < per_producer;) {
+                if (batch == 1) {
+                    if (queue.TryPush(uint64_t(i))) {
+                        ++i;
+                    }
+                    else {
+                        std::this_thread::yield();
+                    }
+                    continue;
+                }
+                const size_t n = std::min(batch, per_producer - i);
+                for (size_t k = 0; k < n; ++k) {
+                    buffer[k] = i + k;
+                }
+                for (size_t pushed = 0; pushed < n;) {
+                    const size_t count = queue.TryPushBatch(std::span<uint64_t>(buffer.data() + pushed, n - pushed));
+                    pushed += count;
+                    if (count == 0) {
+                        std::this_thread::yield();
+                    }
+                }
+                i += n;
+            }
+            });
+    }
+    for (size_t c = 0; c < consumers; ++c) {
+        threads.emplace_back([&]() {
+            std::vector<uint64_t> buffer(batch);
+            uint64_t sum = 0;
+            while (consumed.load(std::memory_order_relaxed) < total) {
+                const size_t count = batch == 1 ? size_t(queue.TryPop(buffer[0])) : queue.TryPopBatch(std::span<uint64_t>(buffer));
+                if (count == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (size_t k = 0; k < count; ++k) {
+                    sum += buffer[k];
+                }
+                consumed.fetch_add(count, std::memory_order_relaxed);
+            }
+            checksum.fetch_add(sum);
+            });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    const uint64_t expected = uint64_t(producers) * (uint64_t(per_producer) * (per_producer - 1) / 2);
+    if (checksum.load() != expected) {
+        std::cout << "queue checksum mismatch\n";
+    }
+    return { std::chrono::duration<double>(elapsed).count(), total, 0 };
+}
+
+template <typename LockFree>
+void reportQueue(const char* name, size_t producers, size_t consumers, size_t items, size_t batch) {
+    auto lock_free = benchmarkQueue<LockFree>(producers, consumers, items, batch);
+    auto locked = benchmarkQueue<MutexQueue<uint64_t>>(producers, consumers, items, batch);
+    std::cout << "=== " << name << " " << producers << "P/" << consumers << "C, batch " << batch << " ===\n"
+        << "lock-free: " << lock_free.opsPerSecond() << " items/sec, "
+        << "mutex: " << locked.opsPerSecond() << " items/sec\n\n";
+}
+
 int main() {
     constexpr size_t ENTITY_COUNT = 1'000'000;
     constexpr size_t ACCESS_COUNT = 10'000'000;
@@ -222,11 +385,24 @@ int main() {
         << res6.opsPerSecond() << " accesses/sec, "
         << res6.microsecondsPerOp() << " us/access\n\n";
 
+    auto res8 = benchmarkComponentLookup(ACCESS_COUNT);
+    std::cout << "=== Cached Component Lookup ===\n"
+        << res8.opsPerSecond() << " accesses/sec, "
+        << res8.microsecondsPerOp() << " us/access\n\n";
+
     auto res7 = runMixedOperationsBenchmark();
     std::cout << "=== Mixed Operations ===\n"
         << res7.opsPerSecond() << " ops/sec, "
         << res7.microsecondsPerOp() << " us/op, Memory: "
-        << res7.memoryString() << "\n";
+        << res7.memoryString() << "\n\n";
+
+    constexpr size_t QUEUE_ITEMS = 4'000'000;
+    reportQueue<spark::threading::SpscRing<uint64_t>>("SPSC Ring", 1, 1, QUEUE_ITEMS, 1);
+    reportQueue<spark::threading::SpscRing<uint64_t>>("SPSC Ring", 1, 1, QUEUE_ITEMS, 64);
+    reportQueue<spark::threading::MpscRing<uint64_t>>("MPSC Ring", 4, 1, QUEUE_ITEMS, 1);
+    reportQueue<spark::threading::MpscRing<uint64_t>>("MPSC Ring", 4, 1, QUEUE_ITEMS, 64);
+    reportQueue<spark::threading::MpmcQueue<uint64_t>>("MPMC Queue", 4, 4, QUEUE_ITEMS, 1);
+    reportQueue<spark::threading::MpmcQueue<uint64_t>>("MPMC Queue", 4, 4, QUEUE_ITEMS, 64);
 
     return 0;
 }
@@ -16,6 +16,8 @@
 #include "spark_camera.hpp"
 #include "spark_math.hpp"
 #include "spark_transform.hpp"
+#include "spark_spatial_index.hpp"
+#include "spark_coroutine.hpp"
 #include "spark_events.hpp"
 
 
@@ -523,6 +523,7 @@ namespace spark
 			DispatchSystemsForPhase(SystemPhase::BEFORE_START);
 			m_layer_stack.Start();
 			DispatchSystemsForPhase(SystemPhase::ON_START);
+			FlushComponentObservers();
 			return *this;
 		}
 
@@ -530,10 +531,18 @@ namespace spark
 		{
 			while (IsRunning())
 			{
+				m_thread_pool.BeginSliceFrame();
 				DispatchSystemsForPhase(SystemPhase::BEFORE_UPDATE);
 				m_layer_stack.Update(m_delta_time);
 				DispatchSystemsForPhase(SystemPhase::UPDATE);
 				DispatchSystemsForPhase(SystemPhase::AFTER_UPDATE);
+				FlushComponentObservers();
+				if (m_main_thread_budget.count() > 0)
+					m_main_thread_queue.Drain(m_main_thread_budget);
+				else
+					m_main_thread_queue.Drain();
+				if (m_dump_pool_stats)
+					DumpThreadPoolStats();
 			}
 			return *this;
 		}
@@ -682,12 +691,62 @@ namespace spark
 			return m_thread_pool;
 		}
 
+		// Logs each worker's counters for the frame at DEBUG level after every frame.
+		// Turns pool telemetry on with it.
+		Application& SetThreadPoolStatsDump(bool enabled)
+		{
+			m_dump_pool_stats = enabled;
+			m_thread_pool.EnableTelemetry(enabled);
+			m_last_pool_stats = m_thread_pool.GetStats();
+			return *this;
+		}
+
+		void DumpThreadPoolStats()
+		{
+			threading::PoolStats stats = m_thread_pool.GetStats();
+			Logln(LogLevel::DEBUG) << stats.Since(m_last_pool_stats).ToString();
+			m_last_pool_stats = std::move(stats);
+		}
+
+		// Drained by Run() once per frame; `co_await GetMainThreadQueue().Schedule()`
+		// brings a coroutine back onto the main thread
+		threading::MainThreadQueue& GetMainThreadQueue()
+		{
+			return m_main_thread_queue;
+		}
+
+		// Runs fn on the main thread, which owns the GL context, at the end of a frame
+		// in Run(), after observers are flushed. Callable from any thread, so workers
+		// can decode an asset and hand the upload back here.
+		template <typename F>
+		void EnqueueOnMainThread(F&& fn)
+		{
+			m_main_thread_queue.Post(std::forward<F>(fn));
+		}
+
+		// Caps the time Run() spends on main-thread work each frame; what doesn't fit
+		// rolls over, in order, to the next frame. Zero, the default, runs it all.
+		Application& SetMainThreadBudget(std::chrono::nanoseconds budget)
+		{
+			m_main_thread_budget = budget;
+			return *this;
+		}
+
+		// Once-per-frame sync point for Coordinator observers. Taken under the
+		// coordinator's resource lock since async systems may still be running.
+		void FlushComponentObservers()
+		{
+			auto coord = GetResource<Coordinator>()->Lock();
+			coord.Get().FlushObservers();
+		}
+
 		void DispatchSystemsForPhase(SystemPhase phase)
 		{
 			auto it = m_systems.find(phase);
 			if (it == m_systems.end())
 				return;
-			std::vector<std::future<void>> sync_tasks;
+			// Sync systems join below; the main thread runs pool tasks while it waits
+			threading::TaskGroup sync_tasks(m_thread_pool);
 			for (auto& sys_ptr : it->second)
 			{
 				switch (sys_ptr->GetExecutionMode())
@@ -697,18 +756,17 @@ namespace spark
 					break;
 				case SystemExecutionMode::MULTITHREADED_SYNC:
 				{
-					auto task = m_thread_pool.Enqueue(
+					sync_tasks.Run(
 						sys_ptr->GetPriority(),
 						[this, &sys_ptr]()
 						{
 							sys_ptr->Execute(*this);
 						}
 					);
-					sync_tasks.emplace_back(std::move(task.result));
 					break;
 				}
 				case SystemExecutionMode::MULTITHREADED_ASYNC:
-					m_thread_pool.Enqueue(
+					m_thread_pool.Submit(
 						sys_ptr->GetPriority(),
 						[this, &sys_ptr]()
 						{
@@ -718,10 +776,7 @@ namespace spark
 					break;
 				}
 			}
-			for (auto& f : sync_tasks)
-			{
-				f.get();
-			}
+			sync_tasks.Wait();
 		}
 
 		IRenderer& GetRenderer()
@@ -845,6 +900,10 @@ namespace spark
 		FactoryRegistry m_factory_registry;
 		std::unique_ptr<ItemManager> m_item_manager;
 		threading::ThreadPool m_thread_pool;
+		threading::MainThreadQueue m_main_thread_queue;
+		std::chrono::nanoseconds m_main_thread_budget{ 0 };
+		threading::PoolStats m_last_pool_stats;
+		bool m_dump_pool_stats = false;
 		DeltaTime<f64> m_delta_time;
 		Coordinator m_coordinator;
 		std::unordered_map<SystemPhase, std::vector<std::unique_ptr<detail::ISystem>>> m_systems;
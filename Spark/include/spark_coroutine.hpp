@@ -0,0 +1,261 @@
+#ifndef SPARK_COROUTINE_HPP
+#define SPARK_COROUTINE_HPP
+
+#include "spark_pch.hpp"
+#include "spark_threading.hpp"
+#include <coroutine>
+
+namespace spark {
+
+    // Lazily started coroutine returning T. Nothing runs until the task is awaited,
+    // handed to SyncWait or Detach. Where it runs is decided by what it awaits:
+    //
+    //     Task<Mesh> LoadMesh(ThreadPool& pool, MainThreadQueue& main, std::string path) {
+    //         co_await pool.Schedule();          // off the caller's thread
+    //         MeshData data = ParseFile(path);
+    //         co_await main.Schedule();          // back on the main thread for the upload
+    //         co_return UploadMesh(data);
+    //     }
+    //
+    //     Task<> LoadLevel(...) {
+    //         Mesh a = co_await LoadMesh(pool, main, "a.obj");
+    //         ...
+    //     }
+    //
+    // A suspended task holds no thread; it is resumed by a pool or queue entry, or by
+    // the task it awaits finishing, so thousands of loads in flight cost only their
+    // frames. Awaiting a task hands control to it directly (symmetric transfer) and the
+    // awaiting coroutine continues on whichever thread the child finished on.
+    template <typename T = void>
+    class Task;
+
+    namespace detail {
+
+        struct TaskPromiseBase {
+            std::coroutine_handle<> continuation;  // Whoever co_awaits us
+            std::exception_ptr error;
+            bool detached = false;                 // Frame frees itself at the end
+            std::atomic<bool>* done_flag = nullptr; // Set by SyncWait
+            threading::ThreadPool* wait_pool = nullptr;
+
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                    TaskPromiseBase& promise = handle.promise();
+                    if (promise.continuation) {
+                        return promise.continuation;
+                    }
+                    if (promise.detached) {
+                        handle.destroy();
+                    }
+                    else if (promise.done_flag) {
+                        // The waiter may free the frame as soon as the flag is set
+                        threading::ThreadPool* pool = promise.wait_pool;
+                        promise.done_flag->store(true, std::memory_order_release);
+                        pool->NotifyWaiters();
+                    }
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+
+            void unhandled_exception() noexcept {
+                error = std::current_exception();
+            }
+        };
+
+        template <typename T>
+        struct TaskPromise : TaskPromiseBase {
+            std::optional<T> value;
+
+            Task<T> get_return_object() noexcept;
+
+            template <typename U>
+            void return_value(U&& v) {
+                value.emplace(std::forward<U>(v));
+            }
+
+            T TakeResult() {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                return std::move(*value);
+            }
+        };
+
+        template <>
+        struct TaskPromise<void> : TaskPromiseBase {
+            Task<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void TakeResult() {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+    }
+
+    template <typename T>
+    class Task {
+        static_assert(!std::is_reference_v<T>, "Task<T&> is not supported; return a pointer");
+
+    public:
+        using promise_type = detail::TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Task() = default;
+
+        explicit Task(Handle handle)
+            : m_handle(handle) {
+        }
+
+        Task(Task&& other) noexcept
+            : m_handle(std::exchange(other.m_handle, nullptr)) {
+        }
+
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        // Destroying a task that was started but hasn't finished is a bug
+        ~Task() {
+            Reset();
+        }
+
+        bool Valid() const {
+            return static_cast<bool>(m_handle);
+        }
+
+        bool IsDone() const {
+            return m_handle && m_handle.done();
+        }
+
+        struct Awaiter {
+            Handle handle;
+
+            bool await_ready() const noexcept {
+                return handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() {
+                return handle.promise().TakeResult();
+            }
+        };
+
+        // Starts the task and suspends the caller until it finishes; yields its result
+        // or rethrows its exception
+        Awaiter operator co_await() && noexcept {
+            return { m_handle };
+        }
+
+        Awaiter operator co_await() & noexcept {
+            return { m_handle };
+        }
+
+    private:
+        template <typename U>
+        friend U SyncWait(threading::ThreadPool& pool, Task<U> task, threading::TaskPriority priority);
+
+        template <typename U>
+        friend U SyncWait(threading::ThreadPool& pool, threading::MainThreadQueue& queue, Task<U> task,
+            threading::TaskPriority priority);
+
+        template <typename U>
+        friend void Detach(Task<U> task);
+
+        void Reset() {
+            if (m_handle) {
+                m_handle.destroy();
+                m_handle = nullptr;
+            }
+        }
+
+        Handle m_handle;
+    };
+
+    namespace detail {
+
+        template <typename T>
+        Task<T> TaskPromise<T>::get_return_object() noexcept {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+    }
+
+    // Runs the task to completion from ordinary code. It starts on the calling thread,
+    // which then helps with `pool`'s work until the task finishes. Returns the result
+    // or rethrows the task's exception. `priority` is what the task schedules its pool
+    // hops at; off the pool, the caller only helps with work at least that urgent.
+    //
+    // The waiting thread drains no MainThreadQueue, so the task must not resume on a
+    // queue this thread owns (as LoadMesh above does with `main`): it would never run.
+    // Use the overload taking the queue for that.
+    template <typename T>
+    T SyncWait(threading::ThreadPool& pool, Task<T> task, threading::TaskPriority priority) {
+        std::atomic<bool> done{ false };
+        typename Task<T>::promise_type& promise = task.m_handle.promise();
+        promise.done_flag = &done;
+        promise.wait_pool = &pool;
+        task.m_handle.resume();
+        pool.WaitUntil([&done]() { return done.load(std::memory_order_acquire); }, priority);
+        return promise.TakeResult();
+    }
+
+    template <typename T>
+    T SyncWait(threading::ThreadPool& pool, Task<T> task) {
+        return SyncWait(pool, std::move(task), threading::TaskPriority::NORMAL);
+    }
+
+    // As above, for a caller that owns `queue`: entries posted to it, such as the task
+    // resuming after `co_await queue.Schedule()`, run on this thread while it waits.
+    template <typename T>
+    T SyncWait(threading::ThreadPool& pool, threading::MainThreadQueue& queue, Task<T> task,
+        threading::TaskPriority priority) {
+        std::atomic<bool> done{ false };
+        typename Task<T>::promise_type& promise = task.m_handle.promise();
+        promise.done_flag = &done;
+        promise.wait_pool = &pool;
+        task.m_handle.resume();
+        queue.WaitUntil(pool, [&done]() { return done.load(std::memory_order_acquire); }, priority);
+        return promise.TakeResult();
+    }
+
+    template <typename T>
+    T SyncWait(threading::ThreadPool& pool, threading::MainThreadQueue& queue, Task<T> task) {
+        return SyncWait(pool, queue, std::move(task), threading::TaskPriority::NORMAL);
+    }
+
+    // Starts the task and lets it run on its own; its frame is freed when it finishes.
+    // The result and any exception are discarded.
+    template <typename T>
+    void Detach(Task<T> task) {
+        typename Task<T>::Handle handle = std::exchange(task.m_handle, nullptr);
+        handle.promise().detached = true;
+        handle.resume();
+    }
+}
+
+#endif // SPARK_COROUTINE_HPP
@@ -6,6 +6,8 @@
 #include <cstring>
 #include <type_traits>
 #include <list>
+#include <span>
+#include <string_view>
 
 namespace spark
 {
@@ -63,6 +65,19 @@ namespace spark
         using type = T;
     };
 
+    // Query filter: matches with or without T; the callback receives T* (nullptr when absent)
+    template <typename T>
+    struct Optional
+    {
+        using type = T;
+    };
+
+    // Query filter: archetype must contain at least one of Ts; nothing is passed to the callback
+    template <typename... Ts>
+    struct AnyOf
+    {
+    };
+
     namespace detail
     {
         template <typename T, template <typename...> class Template>
@@ -71,10 +86,77 @@ namespace spark
         template <template <typename...> class Template, typename... Args>
         struct IsSpecialization<Template<Args...>, Template> : std::true_type {};
 
-        inline u32 GetUniqueTypeID()
+        constexpr u64 HashName(std::string_view name)
+        {
+            u64 hash = 14695981039346656037ULL;
+            for (char c : name)
+            {
+                hash ^= static_cast<u8>(c);
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        // One object per component type; its address is the type's identity. Unlike a hash of
+        // the spelled name this stays distinct for same-named types in different translation
+        // units (anonymous namespaces). Non-const so the linker can never fold two of them.
+        template <typename T>
+        inline char g_type_key = 0;
+
+        // Registration table: key -> dense signature bit. Static types are keyed by address,
+        // runtime components by name hash (with a null address). Lookups happen once per type
+        // (GetComponentTypeID caches the result), never on a hot path.
+        struct ComponentRegistry
+        {
+            std::mutex mutex;
+            std::array<const void*, MAX_COMPONENTS> type_keys{};
+            std::array<u64, MAX_COMPONENTS> name_hashes{};
+            u32 count = 0;
+
+            u32 Find(const void* type_key, u64 name_hash) const
+            {
+                for (u32 i = 0; i < count; ++i)
+                {
+                    if (type_keys[i] == type_key && name_hashes[i] == name_hash)
+                        return i;
+                }
+                return MAX_COMPONENTS;
+            }
+        };
+
+        inline ComponentRegistry& GetComponentRegistry()
+        {
+            static ComponentRegistry s_registry;
+            return s_registry;
+        }
+
+        inline u32 RegisterComponentKey(const void* type_key, u64 name_hash)
+        {
+            ComponentRegistry& reg = GetComponentRegistry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            const u32 found = reg.Find(type_key, name_hash);
+            if (found != MAX_COMPONENTS)
+                return found;
+            if (reg.count >= MAX_COMPONENTS)
+            {
+                throw std::runtime_error("Too many component types registered.");
+            }
+            reg.type_keys[reg.count] = type_key;
+            reg.name_hashes[reg.count] = name_hash;
+            return reg.count++;
+        }
+
+        inline u32 RegisterComponentHash(u64 hash)
         {
-            static std::atomic<u32> s_last_id{ 0 };
-            return s_last_id++;
+            return RegisterComponentKey(nullptr, hash);
+        }
+
+        // Dense bit for the named component, or MAX_COMPONENTS if it was never registered
+        inline u32 FindComponentHash(u64 hash)
+        {
+            ComponentRegistry& reg = GetComponentRegistry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            return reg.Find(nullptr, hash);
         }
 
         // Move ExtractIncluded to namespace scope
@@ -95,22 +177,180 @@ namespace spark
 
         public:
             using type = std::conditional_t<
-                IsSpecialization<First, Without>::value,
+                IsSpecialization<First, Without>::value || IsSpecialization<First, AnyOf>::value,
                 Tail,
                 decltype(std::tuple_cat(std::declval<std::tuple<First>>(), std::declval<Tail>()))
             >;
         };
     }
 
+    // Throws std::runtime_error once more than MAX_COMPONENTS types are registered
     template <typename T>
-    u32 GetComponentTypeID() noexcept
+    u32 GetComponentTypeID()
     {
-        static const u32 s_type_id = detail::GetUniqueTypeID();
-        // Ensure we don't exceed MAX_COMPONENTS
-        assert(s_type_id < MAX_COMPONENTS);
+        static const u32 s_type_id = detail::RegisterComponentKey(&detail::g_type_key<T>, 0);
         return s_type_id;
     }
 
+    namespace detail
+    {
+        template <typename T>
+        SPARK_ECS_FORCEINLINE ComponentSignature ComponentBit()
+        {
+            return ComponentSignature(1ULL) << GetComponentTypeID<T>();
+        }
+
+        struct QueryMasks
+        {
+            ComponentSignature include = 0;
+            ComponentSignature exclude = 0;
+            ComponentSignature any = 0;
+        };
+
+        template <typename F>
+        struct FilterMask
+        {
+            static void Apply(QueryMasks& m) { m.include |= ComponentBit<F>(); }
+        };
+
+        template <typename T>
+        struct FilterMask<Without<T>>
+        {
+            static void Apply(QueryMasks& m) { m.exclude |= ComponentBit<T>(); }
+        };
+
+        template <typename T>
+        struct FilterMask<Optional<T>>
+        {
+            static void Apply(QueryMasks&) {}
+        };
+
+        template <typename... Ts>
+        struct FilterMask<AnyOf<Ts...>>
+        {
+            static void Apply(QueryMasks& m) { m.any |= (ComponentBit<Ts>() | ... | ComponentSignature(0)); }
+        };
+
+        // One constant set of masks per filter pack, built on first use
+        template <typename... Filters>
+        const QueryMasks& GetQueryMasks()
+        {
+            static const QueryMasks s_masks = []() {
+                QueryMasks m;
+                (FilterMask<Filters>::Apply(m), ...);
+                return m;
+            }();
+            return s_masks;
+        }
+
+        // How a query column is handed out: T& for components, T* for Optional<T>
+        template <typename F>
+        struct ColumnResult
+        {
+            using component = F;
+            using type = F;
+            static SPARK_ECS_FORCEINLINE F& Fetch(std::byte* p) noexcept { return *reinterpret_cast<F*>(p); }
+        };
+
+        template <typename T>
+        struct ColumnResult<Optional<T>>
+        {
+            using component = T;
+            using type = T*;
+            static SPARK_ECS_FORCEINLINE T* Fetch(std::byte* p) noexcept { return reinterpret_cast<T*>(p); }
+        };
+
+        template <typename Tuple>
+        struct ColumnResultTuple;
+
+        template <typename... Fs>
+        struct ColumnResultTuple<std::tuple<Fs...>>
+        {
+            using type = std::tuple<typename ColumnResult<Fs>::type...>;
+        };
+
+        // Component ids of a query's columns, in column order
+        template <typename Tuple>
+        struct ColumnTypeIds;
+
+        template <typename... Fs>
+        struct ColumnTypeIds<std::tuple<Fs...>>
+        {
+            static const std::array<u32, sizeof...(Fs)>& Get()
+            {
+                static const std::array<u32, sizeof...(Fs)> s_ids = { GetComponentTypeID<typename ColumnResult<Fs>::component>()... };
+                return s_ids;
+            }
+        };
+
+        template <typename Tuple>
+        const auto& GetColumnTypeIds()
+        {
+            return ColumnTypeIds<Tuple>::Get();
+        }
+
+        // Maps an integer or floating point key onto an unsigned value with the same
+        // ordering, so radix sorting the result sorts by the original key
+        template <typename K>
+        SPARK_ECS_FORCEINLINE u64 ToRadixKey(K key) noexcept
+        {
+            if constexpr (std::is_same_v<K, bool>)
+            {
+                return key ? 1 : 0;
+            }
+            else if constexpr (std::is_integral_v<K>)
+            {
+                using U = std::make_unsigned_t<K>;
+                u64 bits = static_cast<U>(key);
+                if constexpr (std::is_signed_v<K>)
+                    bits ^= u64(1) << (sizeof(K) * 8 - 1);
+                return bits;
+            }
+            else
+            {
+                static_assert(sizeof(K) == 4 || sizeof(K) == 8, "unsupported floating point key");
+                using U = std::conditional_t<sizeof(K) == 4, u32, u64>;
+                const U bits = std::bit_cast<U>(key);
+                const U sign = U(1) << (sizeof(K) * 8 - 1);
+                // negatives: flip everything; positives: flip the sign bit
+                return (bits & sign) ? U(~bits) : U(bits | sign);
+            }
+        }
+
+        struct RadixItem
+        {
+            u64 key;
+            u32 row;
+        };
+
+        // Stable LSD radix sort, one byte per pass. Passes where every key shares
+        // the same byte are skipped, so narrow keys only pay for the bytes they use.
+        inline void RadixSort(std::vector<RadixItem>& items, usize key_bytes)
+        {
+            std::vector<RadixItem> scratch(items.size());
+            for (usize pass = 0; pass < key_bytes; ++pass)
+            {
+                const u32 shift = static_cast<u32>(pass * 8);
+                std::array<usize, 256> counts{};
+                for (const RadixItem& it : items)
+                    ++counts[(it.key >> shift) & 0xFF];
+                if (counts[(items.front().key >> shift) & 0xFF] == items.size())
+                    continue;
+
+                usize sum = 0;
+                for (usize& c : counts)
+                {
+                    const usize n = c;
+                    c = sum;
+                    sum += n;
+                }
+                for (const RadixItem& it : items)
+                    scratch[counts[(it.key >> shift) & 0xFF]++] = it;
+                items.swap(scratch);
+            }
+        }
+    }
+
     template <typename Tuple>
     struct TupleOfReferences;
 
@@ -130,26 +370,51 @@ namespace spark
         *dst = *src;
     }
 
+    using SwapFn = void (*)(void* a, void* b);
+
+    template <typename T>
+    void SwapComponentFn(void* a, void* b)
+    {
+        using std::swap;
+        swap(*static_cast<T*>(a), *static_cast<T*>(b));
+    }
+
+    // Lifecycle hooks for runtime-defined components (see RegisterDynamicComponent)
+    using ConstructFn = void (*)(void* dst);
+    using DestroyFn = void (*)(void* ptr);
+
     // Global arrays for all component types:
     static inline CopyFn g_copy_fns[MAX_COMPONENTS] = { nullptr };
+    static inline SwapFn g_swap_fns[MAX_COMPONENTS] = { nullptr };
     static inline usize g_type_sizes[MAX_COMPONENTS] = { 0 };
+    static inline usize g_type_aligns[MAX_COMPONENTS] = { 0 };
+    static inline ConstructFn g_construct_fns[MAX_COMPONENTS] = { nullptr };
+    static inline DestroyFn g_destroy_fns[MAX_COMPONENTS] = { nullptr };
+    // Bit set for every type with a destroy hook, so teardown can skip the rest
+    static inline ComponentSignature g_destroy_mask = 0;
 
     template <typename T>
     void InitTypeIfNeeded()
     {
-        u32 tid = GetComponentTypeID<T>();
-        if (g_type_sizes[tid] == 0)
-        {
+        // Function-local static so staging worlds filled on worker threads
+        // can register types concurrently without racing on the global tables
+        static const bool s_inited = []() {
+            u32 tid = GetComponentTypeID<T>();
             g_type_sizes[tid] = sizeof(T);
+            g_type_aligns[tid] = alignof(T);
             if constexpr (std::is_trivially_copyable_v<T>)
             {
                 g_copy_fns[tid] = nullptr;
+                g_swap_fns[tid] = nullptr;
             }
             else
             {
                 g_copy_fns[tid] = &CopyComponentFn<T>;
+                g_swap_fns[tid] = &SwapComponentFn<T>;
             }
-        }
+            return true;
+        }();
+        (void)s_inited;
     }
 
     // Chunk: SoA data portion for a given signature
@@ -174,17 +439,25 @@ namespace spark
 
             // Calculate total_size_per_entity, gather TIDs
             m_total_size_per_entity = 0; // Initialize the member variable
+            usize max_align = 1;
             for (u32 tid = 0; tid < MAX_COMPONENTS; ++tid)
             {
                 if ((m_signature >> tid) & 1ULL)
                 {
                     usize sz = g_type_sizes[tid];
+                    usize align = std::max<usize>(g_type_aligns[tid], 1);
+                    max_align = std::max(max_align, align);
+                    m_total_size_per_entity = (m_total_size_per_entity + align - 1) & ~(align - 1);
                     m_type_ids.push_back(tid);
                     m_type_sizes.push_back(sz);
                     m_component_offsets.push_back(m_total_size_per_entity); // Update offsets
                     m_total_size_per_entity += sz;
                 }
             }
+            // Round rows up so every row starts on the strictest member alignment;
+            // the buffer itself comes from operator new and is aligned for anything up to that
+            assert(max_align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+            m_total_size_per_entity = (m_total_size_per_entity + max_align - 1) & ~(max_align - 1);
 
             // For large component sets, ensure at least N entities per chunk
             if (m_total_size_per_entity > 0)
@@ -250,6 +523,12 @@ namespace spark
             return m_entities[i];
         }
 
+        // Start of row `i`; rows never move because the buffer is sized once
+        std::byte* GetRow(usize i) noexcept
+        {
+            return m_data.data() + i * m_total_size_per_entity;
+        }
+
         usize AddEntity(Entity e) noexcept
         {
             const usize idx = m_entity_count++;
@@ -257,6 +536,62 @@ namespace spark
             return idx;
         }
 
+        usize Capacity() const noexcept
+        {
+            return m_capacity_entities;
+        }
+
+        usize FreeSpace() const noexcept
+        {
+            return m_capacity_entities - m_entity_count;
+        }
+
+        // Appends `count` entities whose data is a copy of `row`, a single entity
+        // slice laid out like this chunk's rows. Returns the index of the first row.
+        usize AddEntitiesFromRow(const Entity* entities, usize count, const std::byte* row) noexcept
+        {
+            assert(count <= FreeSpace());
+            const usize first = m_entity_count;
+            std::copy(entities, entities + count, m_entities.begin() + first);
+            m_entity_count += count;
+            if (m_total_size_per_entity == 0 || count == 0)
+            {
+                return first;
+            }
+
+            std::byte* dst = m_data.data() + first * m_total_size_per_entity;
+            if (m_all_trivial)
+            {
+                // Seed one row, then keep doubling the filled span
+                std::memcpy(dst, row, m_total_size_per_entity);
+                usize filled = 1;
+                while (filled < count)
+                {
+                    const usize n = std::min(filled, count - filled);
+                    std::memcpy(dst + filled * m_total_size_per_entity, dst, n * m_total_size_per_entity);
+                    filled += n;
+                }
+            }
+            else
+            {
+                for (usize j = 0; j < count; ++j)
+                {
+                    std::byte* dst_row = dst + j * m_total_size_per_entity;
+                    for (usize i = 0; i < m_type_ids.size(); ++i)
+                    {
+                        CopyFn fn = g_copy_fns[m_type_ids[i]];
+                        const std::byte* s_ptr = row + m_component_offsets[i];
+                        std::byte* d_ptr = dst_row + m_component_offsets[i];
+                        if (fn)
+                            fn(s_ptr, d_ptr);
+                        else
+                            std::memcpy(d_ptr, s_ptr, m_type_sizes[i]);
+                    }
+                }
+            }
+            return first;
+        }
+
         void RemoveEntity(usize idx) noexcept
         {
             const usize last_idx = m_entity_count - 1;
@@ -279,8 +614,8 @@ namespace spark
                         u32 tid = m_type_ids[i];
                         CopyFn fn = g_copy_fns[tid];
                         usize sz = m_type_sizes[i];
-                        const usize src_offset = m_component_offsets[i] + last_idx * sz;
-                        const usize dst_offset = m_component_offsets[i] + idx * sz;
+                        const usize src_offset = m_component_offsets[i] + last_idx * m_total_size_per_entity;
+                        const usize dst_offset = m_component_offsets[i] + idx * m_total_size_per_entity;
                         const void* s_ptr = m_data.data() + src_offset;
                         void* d_ptr = m_data.data() + dst_offset;
                         if (fn)
@@ -297,6 +632,22 @@ namespace spark
             return m_total_size_per_entity;
         }
 
+        const std::vector<u32>& GetTypeIds() const
+        {
+            return m_type_ids;
+        }
+
+        const std::vector<usize>& GetTypeSizes() const
+        {
+            return m_type_sizes;
+        }
+
+        // Heap bytes held by this chunk (component buffer plus entity handles)
+        usize GetReservedBytes() const noexcept
+        {
+            return m_data.capacity() + m_entities.capacity() * sizeof(Entity);
+        }
+
 
         usize GetComponentOffset(u32 tid) const
         {
@@ -319,48 +670,71 @@ namespace spark
             {
                 return;
             }
-            const usize sz = m_type_sizes[arr_index];
-            const usize offset = m_component_offsets[arr_index];
-            std::byte* base = m_data.data();
+            SwapComponent(arr_index, GetRow(idx_a), GetRow(idx_b));
+        }
+
+        // Swaps every component of row `idx` with row `other_idx` of `other`, which must
+        // have the same layout. Non-trivially-copyable components go through their swap,
+        // so e.g. an SSO std::string never ends up pointing into another row.
+        void SwapRowWith(usize idx, Chunk& other, usize other_idx)
+        {
+            assert(other.m_signature == m_signature);
+            std::byte* a = GetRow(idx);
+            std::byte* b = other.GetRow(other_idx);
+            if (a == b)
+            {
+                return;
+            }
+            for (usize i = 0; i < m_type_ids.size(); ++i)
+            {
+                SwapComponent(i, a, b);
+            }
+        }
 
-            std::byte* A = base + offset + idx_a * sz;
-            std::byte* B = base + offset + idx_b * sz;
+        bool IsAllTrivial() const noexcept
+        {
+            return m_all_trivial;
+        }
 
-            for (usize i = 0; i < sz; ++i)
+        void SwapComponent(usize arr_index, std::byte* row_a, std::byte* row_b)
+        {
+            const usize offset = m_component_offsets[arr_index];
+            std::byte* A = row_a + offset;
+            std::byte* B = row_b + offset;
+            if (SwapFn fn = g_swap_fns[m_type_ids[arr_index]])
             {
-                std::byte tmp = A[i];
-                A[i] = B[i];
-                B[i] = tmp;
+                fn(A, B);
+                return;
             }
+            std::swap_ranges(A, A + m_type_sizes[arr_index], B);
         }
 
         void CopyTo(usize idx_src, Chunk* dst_chunk, usize idx_dst) const noexcept
         {
-            if (m_all_trivial)
+            const std::byte* src_row = m_data.data() + idx_src * m_total_size_per_entity;
+            std::byte* dst_row = dst_chunk->m_data.data() + idx_dst * dst_chunk->m_total_size_per_entity;
+            if (m_all_trivial && dst_chunk->m_signature == m_signature)
             {
-                // fast path: memcpy entire entity slice
-                std::memcpy(
-                    dst_chunk->m_data.data() + idx_dst * m_total_size_per_entity,
-                    m_data.data() + idx_src * m_total_size_per_entity,
-                    m_total_size_per_entity);
+                // fast path: identical layout, memcpy entire entity slice
+                std::memcpy(dst_row, src_row, m_total_size_per_entity);
+                return;
             }
-            else
+
+            // Layouts differ (archetype move) or a custom copy is needed:
+            // copy each component both chunks share to its offset in the destination
+            for (usize i = 0; i < m_type_ids.size(); ++i)
             {
-                // slow path: per-component copy or custom fn
-                for (usize i = 0; i < m_type_ids.size(); ++i)
-                {
-                    u32 tid = m_type_ids[i];
-                    CopyFn fn = g_copy_fns[tid];
-                    usize sz = m_type_sizes[i];
-                    const usize src_offset = m_component_offsets[i] + idx_src * sz;
-                    const usize dst_offset = dst_chunk->m_component_offsets[i] + idx_dst * sz;
-                    const void* s_ptr = &m_data[src_offset];
-                    void* d_ptr = &dst_chunk->m_data[dst_offset];
-                    if (fn)
-                        fn(s_ptr, d_ptr);
-                    else
-                        std::memcpy(d_ptr, s_ptr, sz);
-                }
+                u32 tid = m_type_ids[i];
+                const i32 dst_i = dst_chunk->m_type_map[tid];
+                if (dst_i < 0)
+                    continue;
+                CopyFn fn = g_copy_fns[tid];
+                const void* s_ptr = src_row + m_component_offsets[i];
+                void* d_ptr = dst_row + dst_chunk->m_component_offsets[dst_i];
+                if (fn)
+                    fn(s_ptr, d_ptr);
+                else
+                    std::memcpy(d_ptr, s_ptr, m_type_sizes[i]);
             }
         }
 
@@ -389,6 +763,12 @@ namespace spark
             return m_entities;
         }
 
+        // Rewrites the handle stored in a row without touching component data
+        void SetEntity(usize i, Entity e) noexcept
+        {
+            m_entities[i] = e;
+        }
+
     private:
         ComponentSignature m_signature;
         usize m_capacity_bytes = 0;
@@ -425,6 +805,18 @@ namespace spark
             : m_signature(sig)
         {
             AddChunk();
+            const Chunk& layout = m_chunks.front();
+            for (u32 tid : layout.GetTypeIds())
+            {
+                m_column_offsets[tid] = static_cast<u32>(layout.GetComponentOffset(tid));
+            }
+        }
+
+        // Offset of component `tid` inside an entity row. Unchecked: callers must
+        // know the component is part of this archetype (0 otherwise).
+        u32 GetColumnOffset(u32 tid) const noexcept
+        {
+            return m_column_offsets[tid];
         }
 
         const ComponentSignature& GetSignature() const
@@ -444,6 +836,16 @@ namespace spark
             return { &chunk_ref, idx };
         }
 
+        // Tail chunk, with a fresh one appended first if it is full
+        Chunk& GetChunkWithSpace()
+        {
+            if (!m_chunks.back().HasSpace())
+            {
+                AddChunk();
+            }
+            return m_chunks.back();
+        }
+
         void RemoveEntity(Chunk* chunk_ptr, usize idx_in_chunk)
         {
             chunk_ptr->RemoveEntity(idx_in_chunk);
@@ -465,7 +867,109 @@ namespace spark
             return m_chunks;
         }
 
+        // Moves every non-empty chunk of `other` into this archetype without copying
+        // component data. Spliced chunks go in front of our tail chunk so new
+        // entities keep filling the chunk that still has space.
+        void SpliceChunksFrom(Archetype& other)
+        {
+            assert(other.m_signature == m_signature);
+            auto insert_pos = std::prev(m_chunks.end());
+            for (auto it = other.m_chunks.begin(); it != other.m_chunks.end();)
+            {
+                auto next = std::next(it);
+                if (it->Size() > 0)
+                {
+                    m_chunks.splice(insert_pos, other.m_chunks, it);
+                }
+                it = next;
+            }
+            if (other.m_chunks.empty())
+            {
+                other.AddChunk();
+            }
+        }
+
+        // Reorders the archetype's rows so row i (counting across chunks in list order)
+        // receives the row previously at order[i]. Chunk fill counts are unchanged.
+        // Trivial rows are staged and copied back bytewise; otherwise rows are swapped
+        // into place cycle by cycle, one component at a time (see Chunk::SwapRowWith).
+        void PermuteRows(const std::vector<u32>& order)
+        {
+            if (!m_chunks.front().IsAllTrivial())
+            {
+                PermuteRowsBySwaps(order);
+                return;
+            }
+            const usize row_size = m_chunks.front().GetTotalSizePerEntity();
+            std::vector<std::byte*> rows;
+            std::vector<Entity> entities;
+            rows.reserve(order.size());
+            entities.reserve(order.size());
+            for (Chunk& chunk : m_chunks)
+            {
+                for (usize i = 0; i < chunk.Size(); ++i)
+                {
+                    rows.push_back(chunk.GetRow(i));
+                    entities.push_back(chunk.GetEntity(i));
+                }
+            }
+            assert(rows.size() == order.size());
+
+            std::vector<std::byte> staged(order.size() * row_size);
+            for (usize i = 0; i < order.size(); ++i)
+            {
+                if (row_size > 0)
+                    std::memcpy(staged.data() + i * row_size, rows[order[i]], row_size);
+            }
+
+            usize i = 0;
+            for (Chunk& chunk : m_chunks)
+            {
+                for (usize j = 0; j < chunk.Size(); ++j, ++i)
+                {
+                    chunk.SetEntity(j, entities[order[i]]);
+                }
+                if (row_size > 0 && chunk.Size() > 0)
+                {
+                    const usize first = i - chunk.Size();
+                    std::memcpy(chunk.GetRow(0), staged.data() + first * row_size, chunk.Size() * row_size);
+                }
+            }
+        }
+
     private:
+        void PermuteRowsBySwaps(const std::vector<u32>& order)
+        {
+            std::vector<std::pair<Chunk*, usize>> rows;
+            rows.reserve(order.size());
+            for (Chunk& chunk : m_chunks)
+            {
+                for (usize i = 0; i < chunk.Size(); ++i)
+                    rows.emplace_back(&chunk, i);
+            }
+            assert(rows.size() == order.size());
+
+            // Walk each cycle of the permutation: every swap settles one row for good
+            std::vector<bool> placed(order.size(), false);
+            for (usize start = 0; start < order.size(); ++start)
+            {
+                if (placed[start])
+                    continue;
+                placed[start] = true;
+                for (usize j = start; order[j] != start; j = order[j])
+                {
+                    const usize k = order[j];
+                    auto [chunk_j, idx_j] = rows[j];
+                    auto [chunk_k, idx_k] = rows[k];
+                    chunk_j->SwapRowWith(idx_j, *chunk_k, idx_k);
+                    const Entity e = chunk_j->GetEntity(idx_j);
+                    chunk_j->SetEntity(idx_j, chunk_k->GetEntity(idx_k));
+                    chunk_k->SetEntity(idx_k, e);
+                    placed[k] = true;
+                }
+            }
+        }
+
         void AddChunk()
         {
             m_chunks.emplace_back(m_signature);
@@ -476,13 +980,55 @@ namespace spark
         ComponentSignature m_signature;
         // Using list to keep chunk pointers stable across insertions
         std::list<Chunk> m_chunks;
+        // tid -> row offset; every chunk of an archetype shares the same layout
+        std::array<u32, MAX_COMPONENTS> m_column_offsets{};
+    };
+
+    struct ComponentColumnStats
+    {
+        u32 type_id = 0;
+        usize size_per_entity = 0;
+        usize bytes_used = 0;       // size_per_entity * live entities
+    };
+
+    struct ArchetypeStats
+    {
+        ComponentSignature signature = 0;
+        usize entity_count = 0;
+        usize chunk_count = 0;
+        usize bytes_reserved = 0;   // everything the chunks allocated
+        usize bytes_used = 0;       // component bytes + handles of live entities
+        f32 average_fill = 0.0f;    // live rows / row capacity, 0..1
+        std::vector<ComponentColumnStats> columns;
+    };
+
+    struct CoordinatorStats
+    {
+        usize entity_count = 0;
+        usize archetype_count = 0;
+        usize chunk_count = 0;
+        usize bytes_reserved = 0;
+        usize bytes_used = 0;
+        usize bookkeeping_bytes = 0; // entity tables, indices and prefabs
+        f32 average_fill = 0.0f;
+        std::vector<ArchetypeStats> archetypes;
     };
 
+    // Handle returned by Coordinator::RegisterPrefab
+    using PrefabId = u32;
+
+    // Handle returned by Coordinator::OnAdd/OnRemove/OnSet/Observe
+    using ObserverId = u32;
+
+    enum class ComponentEvent : u8 { ADD = 0, SET, REMOVE, COUNT };
+
     struct EntityLocation
     {
         Archetype* archetype_ptr = nullptr;
         Chunk* chunk_ptr = nullptr;
         usize index_in_chunk = 0;
+        // Cached chunk_ptr->GetRow(index_in_chunk), filled in by SetEntityLocation
+        std::byte* row = nullptr;
     };
 
     class Coordinator
@@ -496,6 +1042,22 @@ namespace spark
             m_archetypes.reserve(32);
         }
 
+        ~Coordinator()
+        {
+            // Only runtime-registered components carry destroy hooks
+            for (auto& [sig, arch] : m_archetypes)
+            {
+                const ComponentSignature mask = sig & g_destroy_mask;
+                if (mask == 0)
+                    continue;
+                for (Chunk& chunk : arch->GetChunks())
+                {
+                    for (usize i = 0; i < chunk.Size(); ++i)
+                        DestroyComponents({ arch.get(), &chunk, i, chunk.GetRow(i) }, mask);
+                }
+            }
+        }
+
         Coordinator(const Coordinator&) = delete;
         Coordinator& operator=(const Coordinator&) = delete;
 
@@ -503,13 +1065,7 @@ namespace spark
         template <typename... Components>
         Entity CreateEntity(Components&&... comps)
         {
-            // one-time type init and signature creation per template instantiation
-            static const bool inited = []() {
-                (InitTypeIfNeeded<std::remove_reference_t<Components>>(), ...);
-                return true;
-            }(); (void)inited;
-            static const ComponentSignature sig =
-                ((ComponentSignature(1ULL) << GetComponentTypeID<std::remove_reference_t<Components>>()) | ...);
+            const ComponentSignature sig = GetSignatureFor<std::remove_cvref_t<Components>...>();
             Entity e = CreateEmptyEntity();
             Archetype* arch = GetOrCreateArchetype(sig);
             auto [chunk_ptr, idx] = arch->AddEntity(e);
@@ -517,6 +1073,7 @@ namespace spark
             if constexpr (sizeof...(comps) > 0)
                 FillComponents<Components...>(chunk_ptr, idx, std::forward<Components>(comps)...);
             SetEntityLocation(e.GetId(), { arch, chunk_ptr, idx });
+            RecordEvents(ComponentEvent::ADD, sig, &e, 1);
             return e;
         }
 
@@ -538,8 +1095,11 @@ namespace spark
                 EntityLocation& loc = m_entity_locations[id];
                 if (loc.archetype_ptr)
                 {
-                    loc.archetype_ptr->RemoveEntity(loc.chunk_ptr, loc.index_in_chunk);
-                    loc.archetype_ptr = nullptr;
+                    const ComponentSignature sig = loc.archetype_ptr->GetSignature();
+                    RecordEvents(ComponentEvent::REMOVE, sig, &e, 1);
+                    DestroyComponents(loc, sig & g_destroy_mask);
+                    RemoveRow(loc);
+                    m_entity_locations[id] = {};
                 }
             }
         }
@@ -567,29 +1127,13 @@ namespace spark
                 return GetComponentRef<T>(old_loc);
             }
 
-            // Build new signature
-            ComponentSignature new_sig = old_sig | (ComponentSignature(1ULL) << tid);
-
-            // Move to new archetype
-            Archetype* new_arch = GetOrCreateArchetype(new_sig);
-            auto [new_chunk, new_idx] = new_arch->AddEntity(e);
-
-            // Copy old data
-            old_arch->CopyEntity(old_loc.chunk_ptr, old_loc.index_in_chunk, new_chunk, new_idx);
-
-            // Remove from old
-            old_arch->RemoveEntity(old_loc.chunk_ptr, old_loc.index_in_chunk);
+            // Move to the archetype with T added
+            const EntityLocation& new_loc = MoveEntity(e, old_loc, old_sig | (ComponentSignature(1ULL) << tid));
 
             // Construct T in place
             T tmp{ std::forward<Args>(args)... };
-            SetComponentInChunk<T>(new_chunk, new_idx, tmp);
-
-            // Update location
-            EntityLocation new_loc;
-            new_loc.archetype_ptr = new_arch;
-            new_loc.chunk_ptr = new_chunk;
-            new_loc.index_in_chunk = new_idx;
-            m_entity_locations[id] = new_loc;
+            SetComponentInChunk<T>(new_loc.chunk_ptr, new_loc.index_in_chunk, tmp);
+            RecordEvents(ComponentEvent::ADD, ComponentSignature(1ULL) << tid, &e, 1);
 
             return GetComponentRef<T>(new_loc);
         }
@@ -598,6 +1142,247 @@ namespace spark
             return m_archetypes;
         }
 
+        // Indices into GetArchetypes() of every archetype containing component `tid`,
+        // in ascending order (archetypes are only ever appended)
+        const std::vector<u32>& GetArchetypesWith(u32 tid) const
+        {
+            return m_component_archetypes[tid];
+        }
+
+        // Calls fn(Archetype*) for every archetype whose signature contains all of
+        // `include` and none of `exclude`. Only the archetype list of the rarest
+        // included component is walked, so the cost scales with matches rather than
+        // with the total archetype count.
+        template <typename Fn>
+        void ForEachMatchingArchetype(ComponentSignature include, ComponentSignature exclude, Fn&& fn)
+        {
+            if (include == 0)
+            {
+                for (auto& [sig, arch] : m_archetypes)
+                {
+                    if ((sig & exclude) == 0)
+                        fn(arch.get());
+                }
+                return;
+            }
+
+            const std::vector<u32>* rarest = nullptr;
+            for (ComponentSignature bits = include; bits != 0; bits &= bits - 1)
+            {
+                const std::vector<u32>& list = m_component_archetypes[std::countr_zero(bits)];
+                if (!rarest || list.size() < rarest->size())
+                    rarest = &list;
+            }
+
+            for (u32 arch_idx : *rarest)
+            {
+                auto& [sig, arch] = m_archetypes[arch_idx];
+                if ((sig & include) == include && (sig & exclude) == 0)
+                    fn(arch.get());
+            }
+        }
+
+        // Stable-sorts the rows of every archetype containing T by key_fn(const T&),
+        // so queries visit those entities in key order. Integer and floating point
+        // keys go through a radix sort; anything else uses std::stable_sort and needs
+        // operator<. Order only holds until the next structural change to the archetype.
+        template <typename T, typename KeyFn>
+        void SortArchetype(KeyFn&& key_fn)
+        {
+            using Key = std::remove_cvref_t<std::invoke_result_t<KeyFn&, const T&>>;
+            const u32 tid = GetComponentTypeID<T>();
+
+            std::vector<Key> keys;
+            std::vector<u32> order;
+            std::vector<detail::RadixItem> items;
+            for (u32 arch_idx : m_component_archetypes[tid])
+            {
+                Archetype* arch = m_archetypes[arch_idx].second.get();
+                const u32 offset = arch->GetColumnOffset(tid);
+
+                keys.clear();
+                for (Chunk& chunk : arch->GetChunks())
+                {
+                    for (usize i = 0; i < chunk.Size(); ++i)
+                        keys.push_back(key_fn(*reinterpret_cast<const T*>(chunk.GetRow(i) + offset)));
+                }
+                if (keys.size() < 2 || std::is_sorted(keys.begin(), keys.end()))
+                    continue;
+
+                order.resize(keys.size());
+                if constexpr (std::is_arithmetic_v<Key>)
+                {
+                    items.resize(keys.size());
+                    for (usize i = 0; i < keys.size(); ++i)
+                        items[i] = { detail::ToRadixKey(keys[i]), static_cast<u32>(i) };
+                    detail::RadixSort(items, sizeof(Key));
+                    for (usize i = 0; i < items.size(); ++i)
+                        order[i] = items[i].row;
+                }
+                else
+                {
+                    std::iota(order.begin(), order.end(), 0u);
+                    std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b)
+                        {
+                            return keys[a] < keys[b];
+                        });
+                }
+
+                arch->PermuteRows(order);
+
+                // Every row of the archetype may have moved; rewrite locations in one pass
+                for (Chunk& chunk : arch->GetChunks())
+                {
+                    for (usize i = 0; i < chunk.Size(); ++i)
+                        m_entity_locations[chunk.GetEntity(i).GetId()] = { arch, &chunk, i, chunk.GetRow(i) };
+                }
+            }
+        }
+
+        // Registers an entity template. The components are laid out once as a row of
+        // the target archetype, so each instance is a plain row copy. They are
+        // constructed in the row, so non-trivial ones (strings, vectors) are copied
+        // from a live object, and destroyed with the Coordinator.
+        template <typename... Components>
+        PrefabId RegisterPrefab(Components&&... comps)
+        {
+            const ComponentSignature sig = GetSignatureFor<std::remove_cvref_t<Components>...>();
+            Archetype* arch = GetOrCreateArchetype(sig);
+            const Chunk& layout = arch->GetChunks().front();
+
+            PrefabTemplate prefab;
+            prefab.archetype = arch;
+            prefab.row.resize(layout.GetTotalSizePerEntity());
+            auto write = [&](auto&& comp)
+                {
+                    using T = std::remove_cvref_t<decltype(comp)>;
+                    const usize offset = layout.GetComponentOffset(GetComponentTypeID<T>());
+                    new (prefab.row.data() + offset) T(std::forward<decltype(comp)>(comp));
+                    if constexpr (!std::is_trivially_destructible_v<T>)
+                        prefab.destroy.emplace_back(offset, [](void* ptr) { static_cast<T*>(ptr)->~T(); });
+                };
+            (write(std::forward<Components>(comps)), ...);
+
+            m_prefabs.emplace_back(std::move(prefab));
+            return static_cast<PrefabId>(m_prefabs.size() - 1);
+        }
+
+        // Spawns `count` copies of a prefab, filling chunk rows in bulk
+        std::vector<Entity> Instantiate(PrefabId prefab, usize count)
+        {
+            return Instantiate(prefab, count, [](Entity, usize) {});
+        }
+
+        // As above; `override_fn(entity, instance_index)` runs for each instance once
+        // all rows are written, e.g. to set a per-instance Position
+        template <typename Fn>
+        std::vector<Entity> Instantiate(PrefabId prefab, usize count, Fn&& override_fn)
+        {
+            assert(prefab < m_prefabs.size());
+            const PrefabTemplate& tmpl = m_prefabs[prefab];
+            Archetype* arch = tmpl.archetype;
+
+            std::vector<Entity> entities(count);
+            for (usize i = 0; i < count; ++i)
+            {
+                entities[i] = CreateEmptyEntity();
+            }
+
+            usize done = 0;
+            while (done < count)
+            {
+                Chunk& chunk = arch->GetChunkWithSpace();
+                const usize n = std::min(chunk.FreeSpace(), count - done);
+                const usize first = chunk.AddEntitiesFromRow(entities.data() + done, n, tmpl.row.data());
+                for (usize i = 0; i < n; ++i)
+                {
+                    SetEntityLocation(entities[done + i].GetId(), { arch, &chunk, first + i });
+                }
+                done += n;
+            }
+            RecordEvents(ComponentEvent::ADD, arch->GetSignature(), entities.data(), count);
+
+            for (usize i = 0; i < count; ++i)
+            {
+                override_fn(entities[i], i);
+            }
+            return entities;
+        }
+
+        // Memory and occupancy snapshot. Walks chunk headers only (no component data)
+        // and reuses `out`'s storage, so it can be sampled every frame.
+        void GetStats(CoordinatorStats& out) const
+        {
+            out.entity_count = 0;
+            out.archetype_count = m_archetypes.size();
+            out.chunk_count = 0;
+            out.bytes_reserved = 0;
+            out.bytes_used = 0;
+            out.archetypes.resize(m_archetypes.size());
+
+            usize total_capacity = 0;
+            for (usize a = 0; a < m_archetypes.size(); ++a)
+            {
+                const auto& [sig, arch] = m_archetypes[a];
+                ArchetypeStats& as = out.archetypes[a];
+                as.signature = sig;
+                as.entity_count = 0;
+                as.chunk_count = 0;
+                as.bytes_reserved = 0;
+
+                usize capacity = 0;
+                const Chunk* layout = nullptr;
+                for (const Chunk& chunk : arch->GetChunks())
+                {
+                    layout = &chunk;
+                    as.entity_count += chunk.Size();
+                    as.bytes_reserved += chunk.GetReservedBytes();
+                    capacity += chunk.Capacity();
+                    ++as.chunk_count;
+                }
+
+                as.columns.clear();
+                usize row_size = 0;
+                if (layout)
+                {
+                    row_size = layout->GetTotalSizePerEntity();
+                    const auto& tids = layout->GetTypeIds();
+                    const auto& sizes = layout->GetTypeSizes();
+                    for (usize i = 0; i < tids.size(); ++i)
+                    {
+                        as.columns.push_back({ tids[i], sizes[i], sizes[i] * as.entity_count });
+                    }
+                }
+                as.bytes_used = as.entity_count * (row_size + sizeof(Entity));
+                as.average_fill = capacity ? static_cast<f32>(as.entity_count) / static_cast<f32>(capacity) : 0.0f;
+
+                out.entity_count += as.entity_count;
+                out.chunk_count += as.chunk_count;
+                out.bytes_reserved += as.bytes_reserved;
+                out.bytes_used += as.bytes_used;
+                total_capacity += capacity;
+            }
+            out.average_fill = total_capacity ? static_cast<f32>(out.entity_count) / static_cast<f32>(total_capacity) : 0.0f;
+
+            usize bookkeeping = m_entity_locations.capacity() * sizeof(EntityLocation)
+                + m_entity_generations.capacity() * sizeof(u32)
+                + m_active_entities.capacity() / 8
+                + m_recycled_ids.size() * sizeof(Entity)
+                + m_archetypes.capacity() * sizeof(m_archetypes[0]);
+            for (const auto& list : m_component_archetypes)
+                bookkeeping += list.capacity() * sizeof(u32);
+            for (const auto& prefab : m_prefabs)
+                bookkeeping += prefab.row.capacity();
+            out.bookkeeping_bytes = bookkeeping;
+        }
+
+        CoordinatorStats GetStats() const
+        {
+            CoordinatorStats stats;
+            GetStats(stats);
+            return stats;
+        }
+
         template <typename T>
         void RemoveComponent(Entity e)
         {
@@ -623,15 +1408,8 @@ namespace spark
                 return;
             }
 
-            ComponentSignature new_sig = old_sig & ~(ComponentSignature(1ULL) << tid);
-
-            Archetype* new_arch = GetOrCreateArchetype(new_sig);
-            auto [new_chunk, new_idx] = new_arch->AddEntity(e);
-
-            old_arch->CopyEntity(old_loc.chunk_ptr, old_loc.index_in_chunk, new_chunk, new_idx);
-            old_arch->RemoveEntity(old_loc.chunk_ptr, old_loc.index_in_chunk);
-
-            m_entity_locations[id] = { new_arch, new_chunk, new_idx };
+            MoveEntity(e, old_loc, old_sig & ~(ComponentSignature(1ULL) << tid));
+            RecordEvents(ComponentEvent::REMOVE, ComponentSignature(1ULL) << tid, &e, 1);
         }
 
         template <typename T>
@@ -661,19 +1439,452 @@ namespace spark
             }
         }
 
+        // Assigns a new value to e's T and reports it to OnSet<T> observers
+        template <typename T>
+        void SetComponent(Entity e, const T& value)
+        {
+            GetComponent<T>(e) = value;
+            MarkChanged<T>(e);
+        }
+
+        // Reports an in-place write (e.g. through GetComponent) to OnSet<T> observers
+        template <typename T>
+        void MarkChanged(Entity e)
+        {
+            RecordEvents(ComponentEvent::SET, detail::ComponentBit<T>(), &e, 1);
+        }
+
+        // Observers see entities in batches: events are buffered per component type as
+        // entities are created, changed, moved between archetypes or destroyed, and
+        // handed over as one span per type at FlushObservers(). At a flush OnRemove runs
+        // first, then OnAdd, then OnSet; added/set entities that no longer hold the
+        // component by then are dropped, so an entity added and removed between two
+        // flushes is only reported as removed. Events raised inside a callback are
+        // delivered at the next flush. Observers must not be added or removed from a callback.
+        using ObserverFn = std::function<void(Coordinator&, std::span<const Entity>)>;
+
+        template <typename T>
+        ObserverId OnAdd(ObserverFn fn)
+        {
+            InitTypeIfNeeded<T>();
+            return Observe(ComponentEvent::ADD, GetComponentTypeID<T>(), std::move(fn));
+        }
+
+        template <typename T>
+        ObserverId OnRemove(ObserverFn fn)
+        {
+            InitTypeIfNeeded<T>();
+            return Observe(ComponentEvent::REMOVE, GetComponentTypeID<T>(), std::move(fn));
+        }
+
+        template <typename T>
+        ObserverId OnSet(ObserverFn fn)
+        {
+            InitTypeIfNeeded<T>();
+            return Observe(ComponentEvent::SET, GetComponentTypeID<T>(), std::move(fn));
+        }
+
+        // Id-based form, also usable with dynamic components
+        ObserverId Observe(ComponentEvent event, u32 component_id, ObserverFn fn)
+        {
+            assert(!m_flushing_observers);
+            const ComponentSignature bit = DynamicComponentBit(component_id);
+            if (m_pending_events.empty())
+            {
+                m_pending_events.resize(static_cast<usize>(ComponentEvent::COUNT) * MAX_COMPONENTS);
+                m_flushed_events.resize(m_pending_events.size());
+            }
+            const ObserverId id = m_next_observer_id++;
+            m_observers.push_back({ id, component_id, event, std::move(fn) });
+            m_observed[static_cast<usize>(event)] |= bit;
+            return id;
+        }
+
+        void RemoveObserver(ObserverId id)
+        {
+            assert(!m_flushing_observers);
+            auto it = std::find_if(m_observers.begin(), m_observers.end(), [id](const Observer& o) { return o.id == id; });
+            if (it == m_observers.end())
+            {
+                return;
+            }
+            const ComponentEvent event = it->event;
+            const u32 tid = it->tid;
+            m_observers.erase(it);
+
+            const bool still_observed = std::any_of(m_observers.begin(), m_observers.end(),
+                [&](const Observer& o) { return o.event == event && o.tid == tid; });
+            if (!still_observed)
+            {
+                m_observed[static_cast<usize>(event)] &= ~(ComponentSignature(1ULL) << tid);
+                m_pending_events[EventSlot(event, tid)].clear();
+            }
+        }
+
+        // Sync point: delivers every buffered event to the observers
+        void FlushObservers()
+        {
+            if (m_observers.empty())
+            {
+                return;
+            }
+            m_flushed_events.swap(m_pending_events);
+            m_flushing_observers = true;
+
+            for (ComponentEvent event : { ComponentEvent::REMOVE, ComponentEvent::ADD, ComponentEvent::SET })
+            {
+                const ComponentSignature observed = m_observed[static_cast<usize>(event)];
+                for (ComponentSignature bits = observed; bits != 0; bits &= bits - 1)
+                {
+                    const u32 tid = static_cast<u32>(std::countr_zero(bits));
+                    std::vector<Entity>& batch = m_flushed_events[EventSlot(event, tid)];
+                    if (event != ComponentEvent::REMOVE)
+                    {
+                        std::erase_if(batch, [&](Entity e) { return !HasComponentId(e, tid); });
+                    }
+                    if (batch.empty())
+                    {
+                        continue;
+                    }
+                    for (Observer& o : m_observers)
+                    {
+                        if (o.event == event && o.tid == tid)
+                            o.fn(*this, batch);
+                    }
+                    batch.clear();
+                }
+            }
+            m_flushing_observers = false;
+        }
+
+        // Registers a component type that only exists at runtime, e.g. one defined by
+        // a mod. The id is an ordinary signature bit, so the data lives in the same
+        // chunks and archetypes as engine components and can be queried by id.
+        // Registering a name again returns the same id and replaces its hooks; a
+        // different layout throws.
+        // Rows are relocated bytewise when entities change archetype, so the data must
+        // not point into itself. `construct` runs when the component is added (the
+        // bytes are zeroed when it is null), `destroy` when it is removed or its entity
+        // is destroyed. Register during loading, not while other threads use the ECS.
+        static u32 RegisterDynamicComponent(std::string_view name, usize size, usize align,
+            ConstructFn construct = nullptr, DestroyFn destroy = nullptr)
+        {
+            if (size == 0 || align == 0 || (align & (align - 1)) != 0 || align > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            {
+                throw std::runtime_error("Invalid size or alignment for dynamic component.");
+            }
+            const u32 tid = detail::RegisterComponentHash(detail::HashName(name));
+            if (g_type_sizes[tid] != 0 && (g_type_sizes[tid] != size || g_type_aligns[tid] != align))
+            {
+                throw std::runtime_error("Dynamic component registered again with a different layout.");
+            }
+
+            const ComponentSignature bit = ComponentSignature(1ULL) << tid;
+            g_type_sizes[tid] = size;
+            g_type_aligns[tid] = align;
+            g_copy_fns[tid] = nullptr;
+            g_swap_fns[tid] = nullptr;
+            g_construct_fns[tid] = construct;
+            g_destroy_fns[tid] = destroy;
+            g_destroy_mask = destroy ? (g_destroy_mask | bit) : (g_destroy_mask & ~bit);
+            return tid;
+        }
+
+        // Id of a dynamic component registered under `name`, if any
+        static std::optional<u32> FindDynamicComponent(std::string_view name)
+        {
+            const u32 tid = detail::FindComponentHash(detail::HashName(name));
+            if (tid == MAX_COMPONENTS)
+                return std::nullopt;
+            return tid;
+        }
+
+        // Creates an entity holding the given components, each constructed in place
+        Entity CreateDynamicEntity(std::span<const u32> component_ids)
+        {
+            ComponentSignature sig = 0;
+            for (u32 tid : component_ids)
+                sig |= DynamicComponentBit(tid);
+
+            Entity e = CreateEmptyEntity();
+            Archetype* arch = GetOrCreateArchetype(sig);
+            auto [chunk_ptr, idx] = arch->AddEntity(e);
+            SetEntityLocation(e.GetId(), { arch, chunk_ptr, idx });
+            ConstructComponents(m_entity_locations[e.GetId()], sig);
+            RecordEvents(ComponentEvent::ADD, sig, &e, 1);
+            return e;
+        }
+
+        // Adds component `component_id` to e and returns its storage. If e already
+        // has it, the existing data is returned untouched.
+        void* AddDynamicComponent(Entity e, u32 component_id)
+        {
+            const ComponentSignature bit = DynamicComponentBit(component_id);
+            const u32 id = e.GetId();
+            if (id >= m_entity_locations.size() || !m_entity_locations[id].archetype_ptr)
+            {
+                throw std::runtime_error("Invalid entity ID in AddDynamicComponent.");
+            }
+
+            EntityLocation old_loc = m_entity_locations[id];
+            const ComponentSignature old_sig = old_loc.archetype_ptr->GetSignature();
+            if (old_sig & bit)
+            {
+                return old_loc.row + old_loc.archetype_ptr->GetColumnOffset(component_id);
+            }
+
+            const EntityLocation& new_loc = MoveEntity(e, old_loc, old_sig | bit);
+            ConstructComponents(new_loc, bit);
+            RecordEvents(ComponentEvent::ADD, bit, &e, 1);
+            return new_loc.row + new_loc.archetype_ptr->GetColumnOffset(component_id);
+        }
+
+        void RemoveDynamicComponent(Entity e, u32 component_id)
+        {
+            const ComponentSignature bit = DynamicComponentBit(component_id);
+            const u32 id = e.GetId();
+            if (id >= m_entity_locations.size() || !m_entity_locations[id].archetype_ptr)
+            {
+                return;
+            }
+
+            EntityLocation old_loc = m_entity_locations[id];
+            const ComponentSignature old_sig = old_loc.archetype_ptr->GetSignature();
+            if (!(old_sig & bit))
+            {
+                return;
+            }
+
+            DestroyComponents(old_loc, bit & g_destroy_mask);
+            MoveEntity(e, old_loc, old_sig & ~bit);
+            RecordEvents(ComponentEvent::REMOVE, bit, &e, 1);
+        }
+
+        // Storage of component `component_id` on e, or nullptr if e doesn't have it
+        void* GetDynamicComponent(Entity e, u32 component_id)
+        {
+            const u32 id = e.GetId();
+            if (id >= m_entity_locations.size() || component_id >= MAX_COMPONENTS)
+            {
+                return nullptr;
+            }
+            const EntityLocation& loc = m_entity_locations[id];
+            if (!loc.archetype_ptr || !((loc.archetype_ptr->GetSignature() >> component_id) & 1ULL))
+            {
+                return nullptr;
+            }
+            return loc.row + loc.archetype_ptr->GetColumnOffset(component_id);
+        }
+
+        bool IsAlive(Entity e) const
+        {
+            const u32 id = e.GetId();
+            return id < m_entity_generations.size()
+                && m_active_entities[id]
+                && m_entity_generations[id] == e.GetGeneration();
+        }
+
+        // Query-style iteration over an explicit entity list (e.g. the result of a
+        // spatial query): calls func(entity, Ts&...) for every entity in `entities`
+        // that is alive and has all of Ts.
+        template <typename... Ts, typename Func>
+        void ForEach(std::span<const Entity> entities, Func&& func)
+        {
+            const ComponentSignature sig = ((ComponentSignature(1ULL) << GetComponentTypeID<Ts>()) | ... | ComponentSignature(0));
+            for (Entity e : entities)
+            {
+                if (!IsAlive(e))
+                    continue;
+                const EntityLocation& loc = m_entity_locations[e.GetId()];
+                if (!loc.archetype_ptr || (loc.archetype_ptr->GetSignature() & sig) != sig)
+                    continue;
+                func(e, GetComponentRef<Ts>(loc)...);
+            }
+        }
+
+        // Moves every live entity of `other` (typically a staging world filled on a
+        // worker thread) into this coordinator. Component ids are process-wide, so
+        // signatures map 1:1; only entity ids are reassigned. Component data is never
+        // copied: whole chunks are spliced into the matching archetype.
+        // Returns the new handle for each of `other`'s entity ids (indexed by old id,
+        // Entity{} for ids that were not alive). `other` is left empty but reusable.
+        std::vector<Entity> MergeFrom(Coordinator& other)
+        {
+            std::vector<Entity> remap(other.m_entity_generations.size());
+            if (&other == this)
+            {
+                return remap;
+            }
+
+            m_active_entities.reserve(m_active_entities.size() + remap.size());
+            m_entity_generations.reserve(m_entity_generations.size() + remap.size());
+            m_entity_locations.reserve(m_entity_locations.size() + remap.size());
+
+            for (auto& [sig, src_arch] : other.m_archetypes)
+            {
+                Archetype* dst_arch = GetOrCreateArchetype(sig);
+                for (auto& chunk : src_arch->GetChunks())
+                {
+                    for (usize i = 0; i < chunk.Size(); ++i)
+                    {
+                        Entity old_e = chunk.GetEntity(i);
+                        Entity new_e = CreateEmptyEntity();
+                        chunk.SetEntity(i, new_e);
+                        // Chunk addresses survive the splice below (std::list nodes)
+                        SetEntityLocation(new_e.GetId(), { dst_arch, &chunk, i });
+                        remap[old_e.GetId()] = new_e;
+                    }
+                    RecordEvents(ComponentEvent::ADD, sig, chunk.GetEntities().data(), chunk.Size());
+                }
+                dst_arch->SpliceChunksFrom(*src_arch);
+            }
+            other.ClearPendingEvents();
+
+            other.m_entity_locations.clear();
+            other.m_recycled_ids = {};
+            other.m_active_entities.clear();
+            other.m_entity_generations.clear();
+            other.m_next_entity_id.store(Entity::INVALID_ID + 1, std::memory_order_relaxed);
+            other.m_local_id_next = 0;
+            other.m_local_id_end = 0;
+            return remap;
+        }
+
+        // Number of entity ids a stager reserves at once
+        static constexpr u32 ENTITY_ID_BLOCK_SIZE = 256;
+
+        // Reserves `count` consecutive never-used entity ids without taking any lock.
+        // Returns the first id; the ids become live once committed.
+        u32 ReserveEntityIds(u32 count) noexcept
+        {
+            return m_next_entity_id.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        // Per-thread entity staging. Ids come from lock-free blocks reserved on the
+        // owning coordinator and rows are written into private chunks, so a worker can
+        // spawn entities without holding the world lock. The returned handles become
+        // valid in the world once the stager is passed to CommitStaged at a sync point.
+        // A stager must only be used by one thread at a time.
+        class EntityStager
+        {
+        public:
+            explicit EntityStager(Coordinator& coord)
+                : m_coord(&coord)
+            {
+            }
+
+            EntityStager(const EntityStager&) = delete;
+            EntityStager& operator=(const EntityStager&) = delete;
+            EntityStager(EntityStager&&) noexcept = default;
+            EntityStager& operator=(EntityStager&&) noexcept = default;
+
+            template <typename... Components>
+            Entity CreateEntity(Components&&... comps)
+            {
+                const ComponentSignature sig = GetSignatureFor<std::remove_cvref_t<Components>...>();
+                Entity e = NextEntity();
+                Archetype* arch = GetOrCreateArchetype(sig);
+                auto [chunk_ptr, idx] = arch->AddEntity(e);
+                if constexpr (sizeof...(comps) > 0)
+                    FillComponents<Components...>(chunk_ptr, idx, std::forward<Components>(comps)...);
+                ++m_count;
+                return e;
+            }
+
+            // Entities staged since the last commit
+            usize Size() const noexcept
+            {
+                return m_count;
+            }
+
+        private:
+            friend class Coordinator;
+
+            Entity NextEntity()
+            {
+                if (m_block_next == m_block_end)
+                {
+                    m_block_next = m_coord->ReserveEntityIds(ENTITY_ID_BLOCK_SIZE);
+                    m_block_end = m_block_next + ENTITY_ID_BLOCK_SIZE;
+                }
+                // Reserved ids have never been handed out, so their generation is 0
+                return Entity(m_block_next++, 0);
+            }
+
+            Archetype* GetOrCreateArchetype(const ComponentSignature& sig)
+            {
+                for (auto& entry : m_archetypes)
+                {
+                    if (entry.first == sig)
+                        return entry.second.get();
+                }
+                auto new_arch = std::make_unique<Archetype>(sig);
+                Archetype* raw = new_arch.get();
+                m_archetypes.emplace_back(sig, std::move(new_arch));
+                return raw;
+            }
+
+        private:
+            Coordinator* m_coord;
+            u32 m_block_next = 0;
+            u32 m_block_end = 0;
+            usize m_count = 0;
+            std::vector<std::pair<ComponentSignature, std::unique_ptr<Archetype>>> m_archetypes;
+        };
+
+        EntityStager CreateStager()
+        {
+            return EntityStager(*this);
+        }
+
+        // Sync point: publishes everything staged in `stager` into this world by
+        // splicing its chunks, and hands the unused tail of its id block back to the
+        // free list. Must be called by whoever owns the world (e.g. under LockedRef).
+        void CommitStaged(EntityStager& stager)
+        {
+            assert(stager.m_coord == this);
+            EnsureEntityCapacity(stager.m_block_end);
+            for (auto& [sig, src_arch] : stager.m_archetypes)
+            {
+                Archetype* dst_arch = GetOrCreateArchetype(sig);
+                for (auto& chunk : src_arch->GetChunks())
+                {
+                    for (usize i = 0; i < chunk.Size(); ++i)
+                    {
+                        u32 id = chunk.GetEntity(i).GetId();
+                        m_active_entities[id] = true;
+                        SetEntityLocation(id, { dst_arch, &chunk, i });
+                    }
+                    RecordEvents(ComponentEvent::ADD, sig, chunk.GetEntities().data(), chunk.Size());
+                }
+                dst_arch->SpliceChunksFrom(*src_arch);
+            }
+
+            for (u32 id = stager.m_block_next; id < stager.m_block_end; ++id)
+            {
+                m_recycled_ids.push(Entity(id, m_entity_generations[id]));
+            }
+            stager.m_block_next = 0;
+            stager.m_block_end = 0;
+            stager.m_count = 0;
+        }
+
         template <typename... Filters>
         class Query
         {
         public:
             using ComponentTypes = std::tuple<Filters...>;
 
+            // Filters handed to the callback: plain components (as T&) and Optional<T> (as T*)
             using IncludedTypes = typename detail::ExtractIncluded<Filters...>::type;
 
+            static constexpr usize COLUMN_COUNT = std::tuple_size<IncludedTypes>::value;
+
             // The result type of this query (single component type or tuple of types)
             using result_type = std::conditional_t<
-                (std::tuple_size<IncludedTypes>::value == 1),
-                std::tuple_element_t<0, IncludedTypes>,
-                IncludedTypes
+                (COLUMN_COUNT == 1),
+                typename detail::ColumnResult<std::tuple_element_t<0, IncludedTypes>>::type,
+                typename detail::ColumnResultTuple<IncludedTypes>::type
             >;
 
             struct ChunkView
@@ -682,46 +1893,37 @@ namespace spark
                 const Entity* m_entity_array = nullptr;
                 usize m_count = 0;
 
-                // Pointer to the start of the data buffer
-                std::byte* m_data = nullptr;
+                // Address of row 0 for each column (nullptr for an absent Optional)
+                std::array<std::byte*, COLUMN_COUNT> m_columns{};
 
-                // Total size of all components per entity
-                usize m_total_size_per_entity = 0;
-
-                // Offsets for each component within an entity's data slice
-                std::array<usize, std::tuple_size<IncludedTypes>::value> m_component_offsets;
+                // Bytes between consecutive rows of a column (0 for an absent Optional)
+                std::array<usize, COLUMN_COUNT> m_steps{};
             };
 
 
             Query(Coordinator& c)
                 : m_coord(c)
-                , m_include_sig(0)
-                , m_exclude_sig(0)
             {
-                // avoid reallocations when gathering chunk views
-                m_chunk_views.reserve(m_coord.GetArchetypes().size());
-                ParseFilters<Filters...>();
+                // Masks and column ids are computed once per filter pack
+                const detail::QueryMasks& masks = detail::GetQueryMasks<Filters...>();
+                m_include_sig = masks.include;
+                m_exclude_sig = masks.exclude;
+                m_any_sig = masks.any;
+
                 // Gather matching archetypes
-                for (auto& kv : m_coord.GetArchetypes())
-                {
-                    const auto& arch_sig = kv.first;
-                    if ((arch_sig & m_include_sig) == m_include_sig)
+                m_coord.ForEachMatchingArchetype(m_include_sig, m_exclude_sig, [this](Archetype* arch)
                     {
-                        if ((arch_sig & m_exclude_sig) != 0ULL)
-                            continue;
-
-                        // Gather chunk data
-                        Archetype* arch = kv.second.get();
+                        if (m_any_sig != 0 && (arch->GetSignature() & m_any_sig) == 0)
+                            return;
                         GatherChunkViews(arch);
-                    }
-                }
+                    });
             }
 
-            // ForEach: pass (entityId, T1&, T2&, ...) to func
+            // ForEach: pass (entityId, T1&, T2&, ...) to func; Optional<T> arrives as T*
             template <typename Func>
             void ForEach(Func func) const noexcept
             {
-                ForEachGeneric(func, std::make_index_sequence<std::tuple_size<IncludedTypes>::value>{});
+                ForEachGeneric(func, std::make_index_sequence<COLUMN_COUNT>{});
             }
 
             // Optimized implementation: precompute per-component base pointers and advance by stride
@@ -733,15 +1935,14 @@ namespace spark
                     const Entity* entities = cv.m_entity_array;
                     usize count = cv.m_count;
                     if (count == 0) continue;
-                    usize stride = cv.m_total_size_per_entity;
-                    std::byte* __restrict bases[sizeof...(I)] = { cv.m_data + cv.m_component_offsets[I]... };
+                    std::byte* __restrict bases[sizeof...(I) + 1] = { cv.m_columns[I]... };
                     for (usize j = 0; j < count; ++j)
                     {
                         func(
                             entities[j],
-                            *reinterpret_cast<std::tuple_element_t<I, IncludedTypes>*>(bases[I])...
+                            detail::ColumnResult<std::tuple_element_t<I, IncludedTypes>>::Fetch(bases[I])...
                         );
-                        ((bases[I] += stride), ...);
+                        ((bases[I] += cv.m_steps[I]), ...);
                     }
                 }
             }
@@ -817,40 +2018,14 @@ namespace spark
             inline Iterator end() const noexcept { return Iterator(this, true); }
 
         private:
-            template <typename First, typename... Rest>
-            void ParseFilters()
-            {
-                SetFilter<First>();
-                if constexpr (sizeof...(Rest) > 0)
-                {
-                    ParseFilters<Rest...>();
-                }
-            }
-
-            void ParseFilters() {}
-
-            template <typename F>
-            void SetFilter()
-            {
-                if constexpr (detail::IsSpecialization<F, Without>::value)
-                {
-                    using TT = typename F::type;
-                    m_exclude_sig |= ComponentSignature(1ULL) << GetComponentTypeID<TT>();
-                }
-                else
-                {
-                    m_include_sig |= ComponentSignature(1ULL) << GetComponentTypeID<F>();
-                }
-            }
-
             // Helper: Given a ChunkView and an entity index, build a tuple of component values
             // by reading the data at the proper offsets.
             template <std::size_t... idxs>
             auto GetTupleFromChunkView(const ChunkView& chunk_view, usize idx, std::index_sequence<idxs...>) const
             {
                 return std::make_tuple(
-                    *reinterpret_cast<std::tuple_element_t<idxs, IncludedTypes>*>(
-                        chunk_view.m_data + idx * chunk_view.m_total_size_per_entity + chunk_view.m_component_offsets[idxs]
+                    detail::ColumnResult<std::tuple_element_t<idxs, IncludedTypes>>::Fetch(
+                        chunk_view.m_columns[idxs] + idx * chunk_view.m_steps[idxs]
                         )...
                 );
             }
@@ -860,19 +2035,30 @@ namespace spark
             // otherwise, return a tuple of the values.
             auto GetResult(const ChunkView& chunk_view, usize idx) const
             {
-                if constexpr (std::tuple_size<IncludedTypes>::value == 1)
+                if constexpr (COLUMN_COUNT == 1)
                 {
                     auto tuple_val = GetTupleFromChunkView(chunk_view, idx, std::make_index_sequence<1>{});
                     return std::get<0>(tuple_val);
                 }
                 else
                 {
-                    return GetTupleFromChunkView(chunk_view, idx, std::make_index_sequence<std::tuple_size<IncludedTypes>::value>{});
+                    return GetTupleFromChunkView(chunk_view, idx, std::make_index_sequence<COLUMN_COUNT>{});
                 }
             }
 
             void GatherChunkViews(Archetype* arch)
             {
+                // Column offsets are per archetype, so bind them once and reuse per chunk
+                const auto& tids = detail::GetColumnTypeIds<IncludedTypes>();
+                const ComponentSignature arch_sig = arch->GetSignature();
+                std::array<usize, COLUMN_COUNT> offsets{};
+                std::array<bool, COLUMN_COUNT> present{};
+                for (usize i = 0; i < COLUMN_COUNT; ++i)
+                {
+                    offsets[i] = arch->GetColumnOffset(tids[i]);
+                    present[i] = ((arch_sig >> tids[i]) & 1ULL) != 0;
+                }
+
                 for (auto& chunk : arch->GetChunks())
                 {
                     if (chunk.Size() == 0)
@@ -883,52 +2069,168 @@ namespace spark
                     cv.m_entity_array = chunk.GetEntities().data();
                     cv.m_count = chunk.Size();
 
-                    // Retrieve the data buffer from the Chunk
-                    const std::vector<std::byte>& data = chunk.GetData();
-                    if (data.empty())
+                    // const_cast: queries hand out mutable component references
+                    std::byte* data = const_cast<std::byte*>(chunk.GetData().data());
+                    const usize stride = chunk.GetTotalSizePerEntity();
+                    for (usize i = 0; i < COLUMN_COUNT; ++i)
                     {
-                        // Handle empty data buffer
-                        cv.m_data = nullptr;
-                    }
-                    else
-                    {
-                        // Assign the data pointer (const_cast is used to remove constness if necessary)
-                        cv.m_data = const_cast<std::byte*>(data.data());
+                        cv.m_columns[i] = present[i] ? data + offsets[i] : nullptr;
+                        cv.m_steps[i] = present[i] ? stride : 0;
                     }
 
-                    cv.m_total_size_per_entity = chunk.GetTotalSizePerEntity();
+                    m_chunk_views.emplace_back(cv);
+                }
+            }
 
-                    // Populate component offsets
-                    FillChunkViewArrays(cv,
-                        std::make_index_sequence<std::tuple_size<IncludedTypes>::value>{});
+        private:
+            Coordinator& m_coord;
+            ComponentSignature m_include_sig = 0;
+            ComponentSignature m_exclude_sig = 0;
+            ComponentSignature m_any_sig = 0;
+            std::vector<ChunkView> m_chunk_views;
+        };
 
-                    m_chunk_views.emplace_back(cv);
+        // Random access to one component type, created once per system run. The
+        // per-archetype row offset lives on the archetype and entity records cache
+        // their row address, so a lookup is a record load plus one add.
+        // Like a Query, it is invalidated by structural changes (create/destroy,
+        // add/remove component) made after it was created.
+        template <typename T>
+        class ComponentLookup
+        {
+        public:
+            explicit ComponentLookup(Coordinator& c)
+                : m_locations(c.m_entity_locations.data())
+                , m_location_count(c.m_entity_locations.size())
+                , m_tid(GetComponentTypeID<T>())
+                , m_bit(ComponentSignature(1ULL) << m_tid)
+            {
+            }
+
+            // Entity must be alive and have T
+            SPARK_ECS_FORCEINLINE T& operator[](Entity e) const noexcept
+            {
+                const EntityLocation& loc = m_locations[e.GetId()];
+                assert(loc.archetype_ptr && (loc.archetype_ptr->GetSignature() & m_bit));
+                return *reinterpret_cast<T*>(loc.row + loc.archetype_ptr->GetColumnOffset(m_tid));
+            }
+
+            bool Has(Entity e) const noexcept
+            {
+                if (e.GetId() >= m_location_count)
+                    return false;
+                const EntityLocation& loc = m_locations[e.GetId()];
+                return loc.archetype_ptr && (loc.archetype_ptr->GetSignature() & m_bit);
+            }
+
+            // nullptr when the entity has no T
+            T* TryGet(Entity e) const noexcept
+            {
+                return Has(e) ? &(*this)[e] : nullptr;
+            }
+
+        private:
+            const EntityLocation* m_locations;
+            usize m_location_count;
+            u32 m_tid;
+            ComponentSignature m_bit;
+        };
+
+        template <typename T>
+        ComponentLookup<T> GetLookup()
+        {
+            InitTypeIfNeeded<T>();
+            return ComponentLookup<T>(*this);
+        }
+
+        // Query over component ids chosen at runtime (dynamic or engine components).
+        // Like Query, the matching chunks are gathered when it is built.
+        class DynamicQuery
+        {
+        public:
+            struct ChunkView
+            {
+                const Entity* m_entity_array = nullptr;
+                usize m_count = 0;
+                // Bytes between consecutive rows of every column
+                usize m_stride = 0;
+                // Row 0 of each requested column, in the order the ids were given
+                std::byte* const* m_columns = nullptr;
+
+                void* Get(usize row, usize column) const noexcept
+                {
+                    return m_columns[column] + row * m_stride;
                 }
+            };
+
+            DynamicQuery(Coordinator& c, std::span<const u32> include, std::span<const u32> exclude = {})
+                : m_include_ids(include.begin(), include.end())
+            {
+                ComponentSignature include_sig = 0;
+                ComponentSignature exclude_sig = 0;
+                for (u32 tid : include)
+                    include_sig |= DynamicComponentBit(tid);
+                for (u32 tid : exclude)
+                    exclude_sig |= DynamicComponentBit(tid);
+
+                std::vector<usize> first_column;
+                c.ForEachMatchingArchetype(include_sig, exclude_sig, [&](Archetype* arch)
+                    {
+                        for (Chunk& chunk : arch->GetChunks())
+                        {
+                            if (chunk.Size() == 0)
+                                continue;
+                            ChunkView cv;
+                            cv.m_entity_array = chunk.GetEntities().data();
+                            cv.m_count = chunk.Size();
+                            cv.m_stride = chunk.GetTotalSizePerEntity();
+                            first_column.push_back(m_column_bases.size());
+                            for (u32 tid : m_include_ids)
+                                m_column_bases.push_back(chunk.GetRow(0) + arch->GetColumnOffset(tid));
+                            m_chunk_views.push_back(cv);
+                        }
+                    });
+                // Bases are only stable once gathering is done
+                for (usize i = 0; i < m_chunk_views.size(); ++i)
+                    m_chunk_views[i].m_columns = m_column_bases.data() + first_column[i];
             }
 
-            template <size_t... I>
-            void FillChunkViewArrays(ChunkView& cv, std::index_sequence<I...>)
+            // fn(const ChunkView&) once per non-empty chunk
+            template <typename Func>
+            void ForEachChunk(Func&& func) const
             {
-                // Retrieve total size per entity from the chunk
-                cv.m_total_size_per_entity = cv.m_chunk->GetTotalSizePerEntity();
+                for (const ChunkView& cv : m_chunk_views)
+                    func(cv);
+            }
 
-                // Populate component offsets
-                (FillOneArray<I, std::tuple_element_t<I, IncludedTypes>>(cv), ...);
+            // fn(Entity, void* const* components), components[i] being the i-th requested id
+            template <typename Func>
+            void ForEach(Func&& func) const
+            {
+                const usize column_count = m_include_ids.size();
+                std::vector<void*> components(column_count);
+                for (const ChunkView& cv : m_chunk_views)
+                {
+                    for (usize j = 0; j < cv.m_count; ++j)
+                    {
+                        for (usize k = 0; k < column_count; ++k)
+                            components[k] = cv.m_columns[k] + j * cv.m_stride;
+                        func(cv.m_entity_array[j], static_cast<void* const*>(components.data()));
+                    }
+                }
             }
 
-            template <size_t IDX, typename T>
-            void FillOneArray(ChunkView& cv)
+            usize Size() const noexcept
             {
-                u32 tid = GetComponentTypeID<T>();
-                // Retrieve the offset of component T within the entity's data slice
-                usize offset = cv.m_chunk->GetComponentOffset(tid);
-                cv.m_component_offsets[IDX] = offset;
+                usize total = 0;
+                for (const ChunkView& cv : m_chunk_views)
+                    total += cv.m_count;
+                return total;
             }
 
         private:
-            Coordinator& m_coord;
-            ComponentSignature m_include_sig;
-            ComponentSignature m_exclude_sig;
+            std::vector<u32> m_include_ids;
+            std::vector<std::byte*> m_column_bases;
             std::vector<ChunkView> m_chunk_views;
         };
 
@@ -939,6 +2241,11 @@ namespace spark
             return Query<Fs...>(*this);
         }
 
+        DynamicQuery CreateDynamicQuery(std::span<const u32> include, std::span<const u32> exclude = {})
+        {
+            return DynamicQuery(*this, include, exclude);
+        }
+
     private:
         std::vector<EntityLocation> m_entity_locations;
 
@@ -950,6 +2257,50 @@ namespace spark
         // Archetypes by signature; use vector for faster small-count linear search
         std::vector<std::pair<ComponentSignature, std::unique_ptr<Archetype>>> m_archetypes;
 
+        struct Observer
+        {
+            ObserverId id;
+            u32 tid;
+            ComponentEvent event;
+            ObserverFn fn;
+        };
+        std::vector<Observer> m_observers;
+        ObserverId m_next_observer_id = 0;
+        // Per event kind, the components that have at least one observer
+        std::array<ComponentSignature, static_cast<usize>(ComponentEvent::COUNT)> m_observed{};
+        // Indexed by EventSlot; sized when the first observer is added
+        std::vector<std::vector<Entity>> m_pending_events;
+        std::vector<std::vector<Entity>> m_flushed_events;
+        bool m_flushing_observers = false;
+
+        struct PrefabTemplate
+        {
+            Archetype* archetype = nullptr;
+            std::vector<std::byte> row;
+            // Row offset and destructor of each component that needs one
+            std::vector<std::pair<usize, DestroyFn>> destroy;
+
+            PrefabTemplate() = default;
+            PrefabTemplate(PrefabTemplate&&) noexcept = default;
+            PrefabTemplate& operator=(PrefabTemplate&&) = delete;
+
+            ~PrefabTemplate()
+            {
+                for (auto [offset, fn] : destroy)
+                    fn(row.data() + offset);
+            }
+        };
+        std::vector<PrefabTemplate> m_prefabs;
+
+        // Inverted index: component id -> sorted indices into m_archetypes
+        std::array<std::vector<u32>, MAX_COMPONENTS> m_component_archetypes;
+
+        // Next never-used entity id; the only state stagers touch off the world lock
+        std::atomic<u32> m_next_entity_id{ Entity::INVALID_ID + 1 };
+        // Block the owning thread is currently handing fresh ids out of
+        u32 m_local_id_next = 0;
+        u32 m_local_id_end = 0;
+
     private:
         // create new or reuse old ID
         Entity CreateEmptyEntity()
@@ -960,16 +2311,32 @@ namespace spark
                 m_recycled_ids.pop();
                 m_entity_generations[r.GetId()]++;
                 m_active_entities[r.GetId()] = true;
-                m_entity_locations.emplace_back();
                 return Entity(r.GetId(), m_entity_generations[r.GetId()]);
             }
             else
             {
-                u32 new_id = (u32)m_active_entities.size();
-                m_active_entities.push_back(true);
-                m_entity_generations.push_back(0);
-                m_entity_locations.emplace_back();
-                return Entity(new_id, 0);
+                // Fresh ids come in blocks from the same counter stagers reserve from,
+                // so the common path stays free of atomic read-modify-writes
+                if (m_local_id_next == m_local_id_end)
+                {
+                    m_local_id_next = ReserveEntityIds(ENTITY_ID_BLOCK_SIZE);
+                    m_local_id_end = m_local_id_next + ENTITY_ID_BLOCK_SIZE;
+                    // Size the entity tables for the whole block at once
+                    EnsureEntityCapacity(m_local_id_end);
+                }
+                u32 new_id = m_local_id_next++;
+                m_active_entities[new_id] = true;
+                return Entity(new_id, m_entity_generations[new_id]);
+            }
+        }
+
+        void EnsureEntityCapacity(usize count)
+        {
+            if (m_entity_generations.size() < count)
+            {
+                m_active_entities.resize(count, false);
+                m_entity_generations.resize(count, 0);
+                m_entity_locations.resize(count);
             }
         }
 
@@ -983,12 +2350,28 @@ namespace spark
             }
             auto new_arch = std::make_unique<Archetype>(sig);
             Archetype* raw = new_arch.get();
+            const u32 arch_idx = static_cast<u32>(m_archetypes.size());
             m_archetypes.emplace_back(sig, std::move(new_arch));
+            for (ComponentSignature bits = sig; bits != 0; bits &= bits - 1)
+            {
+                m_component_archetypes[std::countr_zero(bits)].push_back(arch_idx);
+            }
             return raw;
         }
 
+        // one-time type init and signature creation per component pack
+        template <typename... Components>
+        static ComponentSignature GetSignatureFor()
+        {
+            static const ComponentSignature s_sig = []() {
+                (InitTypeIfNeeded<Components>(), ...);
+                return ((ComponentSignature(1ULL) << GetComponentTypeID<Components>()) | ... | ComponentSignature(0));
+            }();
+            return s_sig;
+        }
+
         template <typename T>
-        void SetComponentInChunk(Chunk* c, usize idx, const T& val)
+        static void SetComponentInChunk(Chunk* c, usize idx, const T& val)
         {
             u32 tid = GetComponentTypeID<T>();
             void* data = c->GetComponentData(tid, idx);
@@ -996,9 +2379,9 @@ namespace spark
         }
 
         template <typename First, typename... Rest>
-        void FillComponents(Chunk* chunk_ptr, usize idx, First&& fst, Rest&&... rest)
+        static void FillComponents(Chunk* chunk_ptr, usize idx, First&& fst, Rest&&... rest)
         {
-            SetComponentInChunk<std::remove_reference_t<First>>(chunk_ptr, idx, std::forward<First>(fst));
+            SetComponentInChunk<std::remove_cvref_t<First>>(chunk_ptr, idx, std::forward<First>(fst));
             if constexpr (sizeof...(rest) > 0)
             {
                 FillComponents<Rest...>(chunk_ptr, idx, std::forward<Rest>(rest)...);
@@ -1019,12 +2402,104 @@ namespace spark
             {
                 m_entity_locations.resize(id + 1);
             }
+            loc.row = loc.chunk_ptr ? loc.chunk_ptr->GetRow(loc.index_in_chunk) : nullptr;
             m_entity_locations[id] = loc;
         }
+
+        // Swap-removes the row at `loc` and repoints the entity that was moved into
+        // the hole. Takes a copy since `loc` may live in m_entity_locations.
+        void RemoveRow(EntityLocation loc)
+        {
+            Chunk* chunk = loc.chunk_ptr;
+            const usize idx = loc.index_in_chunk;
+            loc.archetype_ptr->RemoveEntity(chunk, idx);
+            if (idx < chunk->Size())
+            {
+                SetEntityLocation(chunk->GetEntity(idx).GetId(), { loc.archetype_ptr, chunk, idx });
+            }
+        }
+
+        static usize EventSlot(ComponentEvent event, u32 tid) noexcept
+        {
+            return static_cast<usize>(event) * MAX_COMPONENTS + tid;
+        }
+
+        // Buffers `event` for every observed component in `sig`. With no observers
+        // for those components this is a single mask test.
+        SPARK_ECS_FORCEINLINE void RecordEvents(ComponentEvent event, ComponentSignature sig, const Entity* entities, usize count)
+        {
+            for (ComponentSignature bits = sig & m_observed[static_cast<usize>(event)]; bits != 0; bits &= bits - 1)
+            {
+                std::vector<Entity>& pending = m_pending_events[EventSlot(event, static_cast<u32>(std::countr_zero(bits)))];
+                pending.insert(pending.end(), entities, entities + count);
+            }
+        }
+
+        void ClearPendingEvents()
+        {
+            for (std::vector<Entity>& pending : m_pending_events)
+                pending.clear();
+        }
+
+        bool HasComponentId(Entity e, u32 tid) const
+        {
+            return IsAlive(e)
+                && e.GetId() < m_entity_locations.size()
+                && m_entity_locations[e.GetId()].archetype_ptr
+                && ((m_entity_locations[e.GetId()].archetype_ptr->GetSignature() >> tid) & 1ULL);
+        }
+
+        // Moves e's row from `old_loc` into the archetype for `new_sig`, keeping every
+        // component both signatures share. Components the new signature adds are left
+        // for the caller to fill in. Returns the entity's new location.
+        const EntityLocation& MoveEntity(Entity e, EntityLocation old_loc, ComponentSignature new_sig)
+        {
+            Archetype* new_arch = GetOrCreateArchetype(new_sig);
+            auto [new_chunk, new_idx] = new_arch->AddEntity(e);
+            old_loc.archetype_ptr->CopyEntity(old_loc.chunk_ptr, old_loc.index_in_chunk, new_chunk, new_idx);
+            RemoveRow(old_loc);
+            SetEntityLocation(e.GetId(), { new_arch, new_chunk, new_idx });
+            return m_entity_locations[e.GetId()];
+        }
+
+        static ComponentSignature DynamicComponentBit(u32 tid)
+        {
+            if (tid >= MAX_COMPONENTS || g_type_sizes[tid] == 0)
+            {
+                throw std::runtime_error("Unknown component id.");
+            }
+            return ComponentSignature(1ULL) << tid;
+        }
+
+        // Runs the destroy hook of every component in `mask` for the row at `loc`
+        static void DestroyComponents(const EntityLocation& loc, ComponentSignature mask)
+        {
+            for (ComponentSignature bits = mask; bits != 0; bits &= bits - 1)
+            {
+                const u32 tid = static_cast<u32>(std::countr_zero(bits));
+                g_destroy_fns[tid](loc.row + loc.archetype_ptr->GetColumnOffset(tid));
+            }
+        }
+
+        static void ConstructComponents(const EntityLocation& loc, ComponentSignature mask)
+        {
+            for (ComponentSignature bits = mask; bits != 0; bits &= bits - 1)
+            {
+                const u32 tid = static_cast<u32>(std::countr_zero(bits));
+                void* ptr = loc.row + loc.archetype_ptr->GetColumnOffset(tid);
+                if (g_construct_fns[tid])
+                    g_construct_fns[tid](ptr);
+                else
+                    std::memset(ptr, 0, g_type_sizes[tid]);
+            }
+        }
     };
 
     template <typename... Filters>
     using Query = Coordinator::Query<Filters...>;
+
+    template <typename T>
+    using ComponentLookup = Coordinator::ComponentLookup<T>;
 }
 
 #endif // SPARK_ECS_HPP
\ No newline at end of file
@@ -1712,6 +1712,22 @@ public:
     return true;
   }
 
+  // Conservative box test: rejects only if the box's most positive corner
+  // lies behind some plane.
+  bool AABBInFrustum(const Vec<T, 3> &min_point,
+                     const Vec<T, 3> &max_point) const {
+    for (i32 i = 0; i < COUNT; ++i) {
+      Vec<T, 3> p(m_planes[i].x >= T{0} ? max_point.x : min_point.x,
+                  m_planes[i].y >= T{0} ? max_point.y : min_point.y,
+                  m_planes[i].z >= T{0} ? max_point.z : min_point.z);
+      if (Dot(Vec<T, 3>(m_planes[i].x, m_planes[i].y, m_planes[i].z), p) +
+              m_planes[i].w <
+          T{0})
+        return false;
+    }
+    return true;
+  }
+
 private:
   std::array<Vec<T, 4>, COUNT> m_planes;
 };
@@ -0,0 +1,365 @@
+#ifndef SPARK_SPATIAL_INDEX_HPP
+#define SPARK_SPATIAL_INDEX_HPP
+
+#include "spark_pch.hpp"
+#include "spark_ecs.hpp"
+#include "spark_math.hpp"
+
+namespace spark
+{
+    // World-space bounds of an entity; the component SpatialIndex reads from the Coordinator
+    struct SpatialBounds
+    {
+        math::AABB<f32> bounds;
+    };
+
+    // Loose uniform grid over entity bounds. Each entity lives in the cell that holds
+    // its center and queries are widened by the largest half-extent seen, so an update
+    // touches exactly one cell. Changes are queued and applied in one batch by Commit(),
+    // normally once per frame for just the entities that moved.
+    class SpatialIndex
+    {
+    public:
+        explicit SpatialIndex(f32 cell_size = 16.0f)
+            : m_cell_size(cell_size)
+            , m_inv_cell_size(1.0f / cell_size)
+        {
+        }
+
+        void QueueUpdate(Entity e, const math::AABB<f32>& bounds)
+        {
+            m_pending.push_back({ e, bounds, false });
+        }
+
+        void QueueRemove(Entity e)
+        {
+            m_pending.push_back({ e, {}, true });
+        }
+
+        // Queues the current SpatialBounds of every entity in `moved`
+        void QueueMoved(Coordinator& coord, std::span<const Entity> moved)
+        {
+            coord.ForEach<SpatialBounds>(moved, [this](Entity e, SpatialBounds& b)
+                {
+                    QueueUpdate(e, b.bounds);
+                });
+        }
+
+        // Follows SpatialBounds through the coordinator's observers instead of a
+        // per-frame diff: adds and sets (SetComponent/MarkChanged) queue updates,
+        // removals queue removes. They are queued at the coordinator's FlushObservers()
+        // and applied by the next Commit(). Call Untrack before the index goes away.
+        // Tracking another coordinator (or the same one again) untracks the old one first.
+        void Track(Coordinator& coord)
+        {
+            if (m_tracked)
+                Untrack(*m_tracked);
+            auto update = [this](Coordinator& c, std::span<const Entity> batch)
+                {
+                    QueueMoved(c, batch);
+                };
+            m_observers[0] = coord.OnAdd<SpatialBounds>(update);
+            m_observers[1] = coord.OnSet<SpatialBounds>(update);
+            m_observers[2] = coord.OnRemove<SpatialBounds>([this](Coordinator&, std::span<const Entity> batch)
+                {
+                    for (Entity e : batch)
+                        QueueRemove(e);
+                });
+            m_tracked = &coord;
+        }
+
+        // No-op unless the index is tracking `coord`
+        void Untrack(Coordinator& coord)
+        {
+            assert(!m_tracked || m_tracked == &coord);
+            if (m_tracked != &coord)
+                return;
+            for (ObserverId id : m_observers)
+                coord.RemoveObserver(id);
+            m_tracked = nullptr;
+        }
+
+        // Clears the index and queues every entity that currently has SpatialBounds
+        void Rebuild(Coordinator& coord)
+        {
+            Clear();
+            coord.CreateQuery<SpatialBounds>().ForEach([this](Entity e, SpatialBounds& b)
+                {
+                    QueueUpdate(e, b.bounds);
+                });
+            Commit();
+        }
+
+        // Applies every queued update/remove in submission order
+        void Commit()
+        {
+            for (const PendingOp& op : m_pending)
+            {
+                if (op.remove)
+                    RemoveNow(op.entity);
+                else
+                    UpdateNow(op.entity, op.bounds);
+            }
+            m_pending.clear();
+        }
+
+        void Clear()
+        {
+            m_cells.clear();
+            m_slots.clear();
+            m_free_slots.clear();
+            m_slot_of.clear();
+            m_pending.clear();
+            m_max_half_extent = 0.0f;
+        }
+
+        usize Size() const noexcept
+        {
+            return m_slots.size() - m_free_slots.size();
+        }
+
+        // The returned span stays valid until the next query on this index
+        std::span<const Entity> QueryAABB(const math::AABB<f32>& box)
+        {
+            m_results.clear();
+            ForEachCandidateCell(box.min_point, box.max_point, [&](const std::vector<u32>& cell)
+                {
+                    for (u32 slot_idx : cell)
+                    {
+                        const Slot& slot = m_slots[slot_idx];
+                        if (slot.bounds.Intersects(box))
+                            m_results.push_back(slot.entity);
+                    }
+                });
+            return m_results;
+        }
+
+        std::span<const Entity> QuerySphere(const math::Vec3& center, f32 radius)
+        {
+            m_results.clear();
+            const math::Vec3 r(radius);
+            const f32 radius_sq = radius * radius;
+            ForEachCandidateCell(center - r, center + r, [&](const std::vector<u32>& cell)
+                {
+                    for (u32 slot_idx : cell)
+                    {
+                        const Slot& slot = m_slots[slot_idx];
+                        if (DistanceSqToBox(center, slot.bounds) <= radius_sq)
+                            m_results.push_back(slot.entity);
+                    }
+                });
+            return m_results;
+        }
+
+        std::span<const Entity> QueryFrustum(const math::Frustum<f32>& frustum)
+        {
+            m_results.clear();
+            const math::Vec3 loose(m_max_half_extent);
+            for (const auto& [key, cell] : m_cells)
+            {
+                math::Vec3 cell_min = CellMin(key) - loose;
+                math::Vec3 cell_max = CellMin(key) + math::Vec3(m_cell_size) + loose;
+                if (!frustum.AABBInFrustum(cell_min, cell_max))
+                    continue;
+                for (u32 slot_idx : cell)
+                {
+                    const Slot& slot = m_slots[slot_idx];
+                    if (frustum.AABBInFrustum(slot.bounds.min_point, slot.bounds.max_point))
+                        m_results.push_back(slot.entity);
+                }
+            }
+            return m_results;
+        }
+
+    private:
+        static constexpr u32 INVALID_SLOT = std::numeric_limits<u32>::max();
+        // Keeps the float -> integer cell conversion defined for huge or infinite bounds
+        static constexpr f64 MAX_CELL_COORD = 4.0e18;
+
+        // Full integer cell coordinates, so distant cells never share a key
+        struct CellKey
+        {
+            i64 x = 0;
+            i64 y = 0;
+            i64 z = 0;
+
+            bool operator==(const CellKey&) const = default;
+        };
+
+        struct CellKeyHash
+        {
+            usize operator()(const CellKey& k) const noexcept
+            {
+                u64 h = static_cast<u64>(k.x) * 0x9E3779B97F4A7C15ULL;
+                h ^= static_cast<u64>(k.y) * 0xC2B2AE3D27D4EB4FULL + (h >> 29);
+                h ^= static_cast<u64>(k.z) * 0x165667B19E3779F9ULL + (h >> 32);
+                return static_cast<usize>(h ^ (h >> 31));
+            }
+        };
+
+        struct Slot
+        {
+            Entity entity;
+            math::AABB<f32> bounds;
+            CellKey cell;
+            u32 index_in_cell = 0;
+        };
+
+        struct PendingOp
+        {
+            Entity entity;
+            math::AABB<f32> bounds;
+            bool remove = false;
+        };
+
+        i64 CellCoord(f32 v) const
+        {
+            const f32 cell = std::floor(v * m_inv_cell_size);
+            return static_cast<i64>(std::clamp<f64>(cell, -MAX_CELL_COORD, MAX_CELL_COORD));
+        }
+
+        math::Vec3 CellMin(const CellKey& key) const
+        {
+            return math::Vec3(
+                static_cast<f32>(key.x) * m_cell_size,
+                static_cast<f32>(key.y) * m_cell_size,
+                static_cast<f32>(key.z) * m_cell_size);
+        }
+
+        CellKey CellOf(const math::AABB<f32>& b) const
+        {
+            math::Vec3 c = b.GetCenter();
+            return { CellCoord(c.x), CellCoord(c.y), CellCoord(c.z) };
+        }
+
+        static f32 DistanceSqToBox(const math::Vec3& p, const math::AABB<f32>& b)
+        {
+            f32 d = 0.0f;
+            for (usize i = 0; i < 3; ++i)
+            {
+                f32 v = p.m_data[i];
+                if (v < b.min_point.m_data[i]) d += (b.min_point.m_data[i] - v) * (b.min_point.m_data[i] - v);
+                else if (v > b.max_point.m_data[i]) d += (v - b.max_point.m_data[i]) * (v - b.max_point.m_data[i]);
+            }
+            return d;
+        }
+
+        // Visits the cells whose loose bounds can overlap [lo, hi]. Falls back to
+        // walking the occupied cells when that is cheaper than the covered range.
+        template <typename Fn>
+        void ForEachCandidateCell(const math::Vec3& lo, const math::Vec3& hi, Fn&& fn) const
+        {
+            const i64 x0 = CellCoord(lo.x - m_max_half_extent), x1 = CellCoord(hi.x + m_max_half_extent);
+            const i64 y0 = CellCoord(lo.y - m_max_half_extent), y1 = CellCoord(hi.y + m_max_half_extent);
+            const i64 z0 = CellCoord(lo.z - m_max_half_extent), z1 = CellCoord(hi.z + m_max_half_extent);
+            const f64 range = f64(x1 - x0 + 1) * f64(y1 - y0 + 1) * f64(z1 - z0 + 1);
+
+            if (range > static_cast<f64>(m_cells.size()))
+            {
+                for (const auto& [key, cell] : m_cells)
+                    fn(cell);
+                return;
+            }
+            for (i64 z = z0; z <= z1; ++z)
+                for (i64 y = y0; y <= y1; ++y)
+                    for (i64 x = x0; x <= x1; ++x)
+                    {
+                        auto it = m_cells.find(CellKey{ x, y, z });
+                        if (it != m_cells.end())
+                            fn(it->second);
+                    }
+        }
+
+        void UpdateNow(Entity e, const math::AABB<f32>& bounds)
+        {
+            const u32 id = e.GetId();
+            if (id >= m_slot_of.size())
+                m_slot_of.resize(id + 1, INVALID_SLOT);
+
+            math::Vec3 half = bounds.GetExtents();
+            m_max_half_extent = std::max({ m_max_half_extent, half.x, half.y, half.z });
+
+            const CellKey new_cell = CellOf(bounds);
+            u32 slot_idx = m_slot_of[id];
+            if (slot_idx != INVALID_SLOT && m_slots[slot_idx].entity != e)
+            {
+                // The id was recycled: the old entity's slot goes, the new one is inserted
+                RemoveNow(m_slots[slot_idx].entity);
+                slot_idx = INVALID_SLOT;
+            }
+            if (slot_idx == INVALID_SLOT)
+            {
+                if (!m_free_slots.empty())
+                {
+                    slot_idx = m_free_slots.back();
+                    m_free_slots.pop_back();
+                }
+                else
+                {
+                    slot_idx = static_cast<u32>(m_slots.size());
+                    m_slots.emplace_back();
+                }
+                m_slot_of[id] = slot_idx;
+                InsertIntoCell(slot_idx, new_cell);
+            }
+            else if (m_slots[slot_idx].cell != new_cell)
+            {
+                EraseFromCell(slot_idx);
+                InsertIntoCell(slot_idx, new_cell);
+            }
+            m_slots[slot_idx].entity = e;
+            m_slots[slot_idx].bounds = bounds;
+        }
+
+        void RemoveNow(Entity e)
+        {
+            const u32 id = e.GetId();
+            if (id >= m_slot_of.size() || m_slot_of[id] == INVALID_SLOT)
+                return;
+            const u32 slot_idx = m_slot_of[id];
+            // A stale handle whose id now belongs to another entity
+            if (m_slots[slot_idx].entity != e)
+                return;
+            EraseFromCell(slot_idx);
+            m_slot_of[id] = INVALID_SLOT;
+            m_free_slots.push_back(slot_idx);
+        }
+
+        void InsertIntoCell(u32 slot_idx, const CellKey& cell_key)
+        {
+            std::vector<u32>& cell = m_cells[cell_key];
+            m_slots[slot_idx].cell = cell_key;
+            m_slots[slot_idx].index_in_cell = static_cast<u32>(cell.size());
+            cell.push_back(slot_idx);
+        }
+
+        void EraseFromCell(u32 slot_idx)
+        {
+            auto it = m_cells.find(m_slots[slot_idx].cell);
+            std::vector<u32>& cell = it->second;
+            const u32 idx = m_slots[slot_idx].index_in_cell;
+            cell[idx] = cell.back();
+            m_slots[cell[idx]].index_in_cell = idx;
+            cell.pop_back();
+            if (cell.empty())
+                m_cells.erase(it);
+        }
+
+    private:
+        f32 m_cell_size;
+        f32 m_inv_cell_size;
+        // Grows monotonically; Rebuild() resets it
+        f32 m_max_half_extent = 0.0f;
+
+        std::unordered_map<CellKey, std::vector<u32>, CellKeyHash> m_cells;
+        std::vector<Slot> m_slots;
+        std::vector<u32> m_free_slots;
+        std::vector<u32> m_slot_of; // entity id -> slot
+        std::vector<PendingOp> m_pending;
+        std::vector<Entity> m_results;
+        std::array<ObserverId, 3> m_observers{};
+        Coordinator* m_tracked = nullptr; // Owner of m_observers while tracking
+    };
+}
+
+#endif // SPARK_SPATIAL_INDEX_HPP
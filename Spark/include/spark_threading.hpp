@@ -2,6 +2,21 @@
 #define THREAD_POOL_HPP
 
 #include "spark_pch.hpp"
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 // Namespace for the ThreadPool
 namespace spark::threading {
@@ -13,7 +28,7 @@ namespace spark::threading {
     template <typename ReturnType>
     struct TaskResult {
         std::future<ReturnType> result;         // Future for the task's return value
-        std::future<std::thread::id> thread_id; // Future for the executing thread's ID
+        std::future<std::thread::id> thread_id; // Executing thread's ID; only valid() from EnqueueWithThreadId
     };
 
     // Struct to control individual worker threads
@@ -23,237 +38,3137 @@ namespace spark::threading {
         std::atomic<bool> has_reached_sync_point{ false };   // Indicates if the thread has reached a synchronization point
     };
 
+    // Size used to keep independently written atomics on separate cache lines
+    inline constexpr usize CACHE_LINE_SIZE = 64;
+
+    class ThreadPool;
+
+    namespace detail {
+
+        // Fixed-size blocks for task objects and task states, recycled through per-thread
+        // pools so submitting a task doesn't touch the global heap. A block freed on another
+        // thread (the usual case: a worker runs what the main thread submitted) goes back
+        // to its owner through a lock-free list the owner drains when it runs dry.
+        class TaskBlockPool {
+        public:
+            static constexpr usize BLOCK_SIZE = 128;
+            static constexpr usize BLOCK_ALIGN = 16;
+            static constexpr usize BLOCKS_PER_SLAB = 64;
+
+            struct alignas(CACHE_LINE_SIZE) Block {
+                TaskBlockPool* owner;
+                Block* next;
+                alignas(BLOCK_ALIGN) std::byte payload[BLOCK_SIZE - 2 * sizeof(void*)];
+            };
+
+            static constexpr usize PAYLOAD_SIZE = sizeof(Block::payload);
+
+            // A payload of PAYLOAD_SIZE bytes from the calling thread's pool
+            static void* Allocate() {
+                return Local().AllocateBlock()->payload;
+            }
+
+            static void Free(void* payload) {
+                Block* block = reinterpret_cast<Block*>(static_cast<std::byte*>(payload) - offsetof(Block, payload));
+                TaskBlockPool* owner = block->owner;
+                if (owner == Local().m_self) {
+                    block->next = owner->m_local;
+                    owner->m_local = block;
+                    return;
+                }
+                Block* head = owner->m_remote.load(std::memory_order_relaxed);
+                do {
+                    block->next = head;
+                } while (!owner->m_remote.compare_exchange_weak(head, block,
+                    std::memory_order_release, std::memory_order_relaxed));
+            }
+
+        private:
+            // Pools outlive the threads that use them: a thread hands its pool back on exit
+            // and the next new thread adopts it, so blocks still in flight stay valid
+            struct Registry {
+                std::mutex mutex;
+                std::vector<std::unique_ptr<TaskBlockPool>> pools;
+                std::vector<TaskBlockPool*> idle;
+            };
+
+            static Registry& GetRegistry() {
+                // Leaked on purpose: static pools may still return blocks during shutdown
+                static Registry* s_registry = new Registry();
+                return *s_registry;
+            }
+
+            struct LocalHandle {
+                TaskBlockPool* m_self = nullptr;
+
+                TaskBlockPool* AcquirePool() {
+                    Registry& reg = GetRegistry();
+                    std::lock_guard<std::mutex> lock(reg.mutex);
+                    if (!reg.idle.empty()) {
+                        m_self = reg.idle.back();
+                        reg.idle.pop_back();
+                    }
+                    else {
+                        reg.pools.push_back(std::make_unique<TaskBlockPool>());
+                        m_self = reg.pools.back().get();
+                    }
+                    return m_self;
+                }
+
+                Block* AllocateBlock() {
+                    TaskBlockPool* pool = m_self ? m_self : AcquirePool();
+                    if (!pool->m_local) {
+                        pool->m_local = pool->m_remote.exchange(nullptr, std::memory_order_acquire);
+                        if (!pool->m_local) {
+                            pool->AddSlab();
+                        }
+                    }
+                    Block* block = pool->m_local;
+                    pool->m_local = block->next;
+                    return block;
+                }
+
+                ~LocalHandle() {
+                    if (m_self) {
+                        Registry& reg = GetRegistry();
+                        std::lock_guard<std::mutex> lock(reg.mutex);
+                        reg.idle.push_back(m_self);
+                    }
+                }
+            };
+
+            static LocalHandle& Local() {
+                static thread_local LocalHandle t_handle;
+                return t_handle;
+            }
+
+            void AddSlab() {
+                m_slabs.push_back(std::make_unique<Block[]>(BLOCKS_PER_SLAB));
+                Block* slab = m_slabs.back().get();
+                for (usize i = 0; i < BLOCKS_PER_SLAB; ++i) {
+                    slab[i].owner = this;
+                    slab[i].next = (i + 1 < BLOCKS_PER_SLAB) ? &slab[i + 1] : m_local;
+                }
+                m_local = slab;
+            }
+
+            Block* m_local = nullptr;                                      // Owner only
+            alignas(CACHE_LINE_SIZE) std::atomic<Block*> m_remote{ nullptr };  // Frees from other threads
+            std::vector<std::unique_ptr<Block[]>> m_slabs;
+        };
+
+        template <typename T>
+        inline constexpr bool FITS_TASK_BLOCK = sizeof(T) <= TaskBlockPool::PAYLOAD_SIZE
+            && alignof(T) <= TaskBlockPool::BLOCK_ALIGN;
+
+        // Completion state shared by a Spawn()ed task and its TaskHandle
+        struct TaskStateBase {
+            std::atomic<u32> refs{ 2 };
+            std::atomic<u32> done{ 0 };
+            std::exception_ptr error;
+            std::thread::id thread_id;
+            ThreadPool* pool = nullptr;  // Waiters help this pool until done is set
+            TaskPriority priority = TaskPriority::NORMAL; // Least urgent work a waiter helps with
+            void (*destroy)(TaskStateBase*) = nullptr;
+
+            void Release() {
+                if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    destroy(this);
+                }
+            }
+
+            // The caller follows up with pool->NotifyWaiters()
+            void Finish() {
+                thread_id = std::this_thread::get_id();
+                done.store(1, std::memory_order_release);
+            }
+        };
+
+        template <typename R>
+        struct TaskState : TaskStateBase {
+            std::optional<R> value;
+        };
+
+        template <>
+        struct TaskState<void> : TaskStateBase {
+        };
+
+        template <typename R>
+        TaskState<R>* CreateTaskState() {
+            using State = TaskState<R>;
+            State* state;
+            if constexpr (FITS_TASK_BLOCK<State>) {
+                state = new (TaskBlockPool::Allocate()) State();
+                state->destroy = [](TaskStateBase* s) {
+                    static_cast<State*>(s)->~State();
+                    TaskBlockPool::Free(s);
+                    };
+            }
+            else {
+                state = new State();
+                state->destroy = [](TaskStateBase* s) { delete static_cast<State*>(s); };
+            }
+            return state;
+        }
+    }
+
+    // A unit of work as the pool stores it: one pooled block holding the callable
+    // inline (callables too large for the block are boxed on the heap)
+    struct Task {
+        using Thunk = void (*)(Task*);
+
+        static constexpr usize INLINE_SIZE = 80;
+
+        Thunk run = nullptr;      // Invokes the callable, then destroys it
+        Thunk discard = nullptr;  // Destroys the callable without running it
+        TaskPriority priority = TaskPriority::NORMAL;
+        alignas(detail::TaskBlockPool::BLOCK_ALIGN) std::byte storage[INLINE_SIZE];
+
+        template <typename F>
+        static Task* Create(TaskPriority priority, F&& f) {
+            using Fn = std::decay_t<F>;
+            Task* task = new (detail::TaskBlockPool::Allocate()) Task();
+            task->priority = priority;
+            if constexpr (sizeof(Fn) <= INLINE_SIZE && alignof(Fn) <= detail::TaskBlockPool::BLOCK_ALIGN) {
+                new (task->storage) Fn(std::forward<F>(f));
+                task->run = [](Task* t) {
+                    Fn& fn = *std::launder(reinterpret_cast<Fn*>(t->storage));
+                    struct Guard { Fn& fn; ~Guard() { fn.~Fn(); } } guard{ fn };
+                    fn();
+                    };
+                task->discard = [](Task* t) {
+                    std::launder(reinterpret_cast<Fn*>(t->storage))->~Fn();
+                    };
+            }
+            else {
+                new (task->storage) Fn*(new Fn(std::forward<F>(f)));
+                task->run = [](Task* t) {
+                    std::unique_ptr<Fn> fn(*std::launder(reinterpret_cast<Fn**>(t->storage)));
+                    (*fn)();
+                    };
+                task->discard = [](Task* t) {
+                    delete *std::launder(reinterpret_cast<Fn**>(t->storage));
+                    };
+            }
+            return task;
+        }
+
+        // Runs and frees the task; exceptions escaping a fire-and-forget task are dropped
+        static void Execute(Task* task) {
+            try {
+                task->run(task);
+            }
+            catch (...) {
+            }
+            Free(task);
+        }
+
+        static void Discard(Task* task) {
+            task->discard(task);
+            Free(task);
+        }
+
+    private:
+        static void Free(Task* task) {
+            task->~Task();
+            detail::TaskBlockPool::Free(task);
+        }
+    };
+
+    static_assert(detail::FITS_TASK_BLOCK<Task>);
+
+    // Handle to a task started with ThreadPool::Spawn. Move-only; dropping it
+    // doesn't cancel the task.
+    template <typename R>
+    class TaskHandle {
+    public:
+        TaskHandle() = default;
+
+        explicit TaskHandle(detail::TaskState<R>* state)
+            : m_state(state) {
+        }
+
+        TaskHandle(TaskHandle&& other) noexcept
+            : m_state(std::exchange(other.m_state, nullptr)) {
+        }
+
+        TaskHandle& operator=(TaskHandle&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                m_state = std::exchange(other.m_state, nullptr);
+            }
+            return *this;
+        }
+
+        TaskHandle(const TaskHandle&) = delete;
+        TaskHandle& operator=(const TaskHandle&) = delete;
+
+        ~TaskHandle() {
+            Reset();
+        }
+
+        bool Valid() const {
+            return m_state != nullptr;
+        }
+
+        bool IsReady() const {
+            return m_state->done.load(std::memory_order_acquire) != 0;
+        }
+
+        // Runs other pool tasks on this thread until the task is done. Off the pool,
+        // only tasks at least as urgent as this one's priority are taken.
+        void Wait() const;
+
+        // Waits, then returns the result or rethrows the task's exception.
+        // May be called once for non-void results.
+        R Get() {
+            Wait();
+            if (m_state->error) {
+                std::rethrow_exception(m_state->error);
+            }
+            if constexpr (!std::is_void_v<R>) {
+                return std::move(*m_state->value);
+            }
+        }
+
+        // Thread that ran the task; only meaningful once IsReady()
+        std::thread::id GetThreadId() const {
+            Wait();
+            return m_state->thread_id;
+        }
+
+    private:
+        void Reset() {
+            if (m_state) {
+                m_state->Release();
+                m_state = nullptr;
+            }
+        }
+
+        detail::TaskState<R>* m_state = nullptr;
+    };
+
+    // Chase-Lev work-stealing deque (Le et al., "Correct and Efficient Work-Stealing
+    // for Weak Memory Models"). The owning thread pushes and pops at the bottom (LIFO),
+    // any other thread steals from the top (FIFO). T must be trivially copyable;
+    // the pool stores task pointers. Retired ring buffers are kept until destruction
+    // because a thief may still be reading from one.
+    template <typename T>
+    class WorkStealingDeque {
+    public:
+        explicit WorkStealingDeque(usize capacity = 256) {
+            m_rings.push_back(std::make_unique<Ring>(static_cast<i64>(std::bit_ceil(capacity))));
+            m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        // Owner only
+        void Push(T item) {
+            const i64 b = m_bottom.load(std::memory_order_relaxed);
+            const i64 t = m_top.load(std::memory_order_acquire);
+            Ring* ring = m_ring.load(std::memory_order_relaxed);
+            if (b - t > ring->capacity - 1) {
+                ring = Grow(ring, t, b);
+            }
+            ring->Put(b, item);
+            // Release store rather than fence + relaxed store: same ordering, and
+            // visible to thread sanitizers, which don't model standalone fences
+            m_bottom.store(b + 1, std::memory_order_release);
+        }
+
+        // Owner only; takes the most recently pushed item
+        bool Pop(T& out) {
+            const i64 b = m_bottom.load(std::memory_order_relaxed) - 1;
+            Ring* ring = m_ring.load(std::memory_order_relaxed);
+            m_bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            i64 t = m_top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                // Empty
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            out = ring->Get(b);
+            if (t == b) {
+                // Last item: race a concurrent thief for it
+                const bool won = m_top.compare_exchange_strong(t, t + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed);
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        // Any thread; takes the oldest item. Can fail spuriously under contention.
+        bool Steal(T& out) {
+            i64 t = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const i64 b = m_bottom.load(std::memory_order_acquire);
+            if (t >= b) {
+                return false;
+            }
+
+            Ring* ring = m_ring.load(std::memory_order_acquire);
+            T item = ring->Get(t);
+            if (!m_top.compare_exchange_strong(t, t + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return false;
+            }
+            out = item;
+            return true;
+        }
+
+        bool Empty() const {
+            const i64 b = m_bottom.load(std::memory_order_relaxed);
+            const i64 t = m_top.load(std::memory_order_relaxed);
+            return b <= t;
+        }
+
+        // Approximate while other threads are stealing
+        usize Size() const {
+            const i64 b = m_bottom.load(std::memory_order_relaxed);
+            const i64 t = m_top.load(std::memory_order_relaxed);
+            return b > t ? static_cast<usize>(b - t) : 0;
+        }
+
+    private:
+        struct Ring {
+            explicit Ring(i64 cap)
+                : capacity(cap), mask(cap - 1), slots(std::make_unique<std::atomic<T>[]>(static_cast<usize>(cap))) {
+            }
+
+            T Get(i64 i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+            void Put(i64 i, T item) { slots[i & mask].store(item, std::memory_order_relaxed); }
+
+            i64 capacity;
+            i64 mask;
+            std::unique_ptr<std::atomic<T>[]> slots;
+        };
+
+        Ring* Grow(Ring* old_ring, i64 t, i64 b) {
+            m_rings.push_back(std::make_unique<Ring>(old_ring->capacity * 2));
+            Ring* ring = m_rings.back().get();
+            for (i64 i = t; i < b; ++i) {
+                ring->Put(i, old_ring->Get(i));
+            }
+            m_ring.store(ring, std::memory_order_release);
+            return ring;
+        }
+
+        alignas(CACHE_LINE_SIZE) std::atomic<i64> m_top{ 0 };
+        alignas(CACHE_LINE_SIZE) std::atomic<i64> m_bottom{ 0 };
+        alignas(CACHE_LINE_SIZE) std::atomic<Ring*> m_ring{ nullptr };
+        std::vector<std::unique_ptr<Ring>> m_rings; // Owner only; the last one is current
+    };
+
+    // Bounded single-producer single-consumer ring. Each side keeps a cached copy of
+    // the other's index and only reloads it when the ring looks full (or empty), so
+    // in steady state a push or pop touches no line the other side writes. T must be
+    // default-constructible and move-assignable; popped slots hold moved-from values
+    // until they are overwritten or the ring is destroyed.
+    template <typename T>
+    class SpscRing {
+    public:
+        explicit SpscRing(usize capacity)
+            : m_slots(std::bit_ceil(std::max<usize>(capacity, 2)))
+            , m_mask(m_slots.size() - 1) {
+        }
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        usize Capacity() const {
+            return m_slots.size();
+        }
+
+        // Producer only
+        template <typename U>
+        bool TryPush(U&& item) {
+            const usize tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head_cache == m_slots.size()) {
+                m_head_cache = m_head.load(std::memory_order_acquire);
+                if (tail - m_head_cache == m_slots.size()) {
+                    return false;
+                }
+            }
+            m_slots[tail & m_mask] = std::forward<U>(item);
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Producer only. Moves as many of `items`, from the front, as there is room
+        // for and publishes them together; returns how many.
+        usize TryPushBatch(std::span<T> items) {
+            const usize tail = m_tail.load(std::memory_order_relaxed);
+            if (m_slots.size() - (tail - m_head_cache) < items.size()) {
+                m_head_cache = m_head.load(std::memory_order_acquire);
+            }
+            const usize count = std::min(items.size(), m_slots.size() - (tail - m_head_cache));
+            for (usize i = 0; i < count; ++i) {
+                m_slots[(tail + i) & m_mask] = std::move(items[i]);
+            }
+            if (count != 0) {
+                m_tail.store(tail + count, std::memory_order_release);
+            }
+            return count;
+        }
+
+        // Consumer only
+        bool TryPop(T& out) {
+            const usize head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail_cache) {
+                m_tail_cache = m_tail.load(std::memory_order_acquire);
+                if (head == m_tail_cache) {
+                    return false;
+                }
+            }
+            out = std::move(m_slots[head & m_mask]);
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. Fills `out` from the front with what's there; returns how many.
+        usize TryPopBatch(std::span<T> out) {
+            const usize head = m_head.load(std::memory_order_relaxed);
+            if (m_tail_cache - head < out.size()) {
+                m_tail_cache = m_tail.load(std::memory_order_acquire);
+            }
+            const usize count = std::min(out.size(), m_tail_cache - head);
+            for (usize i = 0; i < count; ++i) {
+                out[i] = std::move(m_slots[(head + i) & m_mask]);
+            }
+            if (count != 0) {
+                m_head.store(head + count, std::memory_order_release);
+            }
+            return count;
+        }
+
+        // Exact only when neither side is running
+        usize SizeApprox() const {
+            return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::vector<T> m_slots;
+        usize m_mask;
+        alignas(CACHE_LINE_SIZE) std::atomic<usize> m_head{ 0 };
+        usize m_tail_cache = 0; // Consumer's last look at m_tail
+        alignas(CACHE_LINE_SIZE) std::atomic<usize> m_tail{ 0 };
+        usize m_head_cache = 0; // Producer's last look at m_head
+    };
+
+    // Bounded multi-producer single-consumer ring. Producers claim positions with a CAS
+    // on the tail, checked against the consumer's published head, then mark their slot
+    // ready with its position; the lone consumer needs no RMW at all. A batch push
+    // claims its whole run of slots with one CAS. Same requirements on T as SpscRing.
+    template <typename T>
+    class MpscRing {
+    public:
+        explicit MpscRing(usize capacity)
+            : m_slots(std::bit_ceil(std::max<usize>(capacity, 2)))
+            , m_mask(m_slots.size() - 1) {
+        }
+
+        MpscRing(const MpscRing&) = delete;
+        MpscRing& operator=(const MpscRing&) = delete;
+
+        usize Capacity() const {
+            return m_slots.size();
+        }
+
+        // Any thread
+        template <typename U>
+        bool TryPush(U&& item) {
+            usize tail = m_tail.load(std::memory_order_relaxed);
+            do {
+                // Signed: a stale tail may trail the head, and the CAS will then fail
+                if (static_cast<i64>(tail - m_head.load(std::memory_order_acquire)) >= static_cast<i64>(m_slots.size())) {
+                    return false;
+                }
+            } while (!m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed));
+            Slot& slot = m_slots[tail & m_mask];
+            slot.value = std::forward<U>(item);
+            slot.ready.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Any thread. Moves as many of `items`, from the front, as there is room for;
+        // returns how many.
+        usize TryPushBatch(std::span<T> items) {
+            usize tail = m_tail.load(std::memory_order_relaxed);
+            usize count;
+            do {
+                const i64 used = static_cast<i64>(tail - m_head.load(std::memory_order_acquire));
+                const i64 room = static_cast<i64>(m_slots.size()) - std::max<i64>(used, 0);
+                count = std::min(items.size(), static_cast<usize>(std::max<i64>(room, 0)));
+                if (count == 0) {
+                    return 0;
+                }
+            } while (!m_tail.compare_exchange_weak(tail, tail + count, std::memory_order_relaxed));
+            for (usize i = 0; i < count; ++i) {
+                Slot& slot = m_slots[(tail + i) & m_mask];
+                slot.value = std::move(items[i]);
+                slot.ready.store(tail + i + 1, std::memory_order_release);
+            }
+            return count;
+        }
+
+        // Consumer only. Stops at the first claimed slot whose producer hasn't finished.
+        bool TryPop(T& out) {
+            const usize head = m_head.load(std::memory_order_relaxed);
+            Slot& slot = m_slots[head & m_mask];
+            if (slot.ready.load(std::memory_order_acquire) != head + 1) {
+                return false;
+            }
+            out = std::move(slot.value);
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only
+        usize TryPopBatch(std::span<T> out) {
+            const usize head = m_head.load(std::memory_order_relaxed);
+            usize count = 0;
+            for (; count < out.size(); ++count) {
+                Slot& slot = m_slots[(head + count) & m_mask];
+                if (slot.ready.load(std::memory_order_acquire) != head + count + 1) {
+                    break;
+                }
+                out[count] = std::move(slot.value);
+            }
+            if (count != 0) {
+                m_head.store(head + count, std::memory_order_release);
+            }
+            return count;
+        }
+
+        // Includes slots claimed but not yet written
+        usize SizeApprox() const {
+            const i64 size = static_cast<i64>(m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire));
+            return static_cast<usize>(std::max<i64>(size, 0));
+        }
+
+    private:
+        struct Slot {
+            std::atomic<usize> ready{ 0 }; // Position + 1 once written for that lap
+            T value{};
+        };
+
+        std::vector<Slot> m_slots;
+        usize m_mask;
+        alignas(CACHE_LINE_SIZE) std::atomic<usize> m_head{ 0 };
+        alignas(CACHE_LINE_SIZE) std::atomic<usize> m_tail{ 0 };
+    };
+
+    // Bounded multi-producer multi-consumer queue (Vyukov). Every slot carries a
+    // sequence number telling whose turn it is: its position when free for that lap,
+    // position + 1 once written. Both ends claim with a CAS on their own index, so
+    // producers and consumers only meet on the slots themselves. Batches claim a run
+    // of ready slots with one CAS. Same requirements on T as SpscRing.
+    template <typename T>
+    class MpmcQueue {
+    public:
+        explicit MpmcQueue(usize capacity)
+            : m_slots(std::bit_ceil(std::max<usize>(capacity, 2)))
+            , m_mask(m_slots.size() - 1) {
+            for (usize i = 0; i < m_slots.size(); ++i) {
+                m_slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpmcQueue(const MpmcQueue&) = delete;
+        MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+        usize Capacity() const {
+            return m_slots.size();
+        }
+
+        template <typename U>
+        bool TryPush(U&& item) {
+            usize pos = m_tail.load(std::memory_order_relaxed);
+            while (true) {
+                Slot& slot = m_slots[pos & m_mask];
+                const i64 diff = static_cast<i64>(slot.sequence.load(std::memory_order_acquire) - pos);
+                if (diff == 0) {
+                    if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        slot.value = std::forward<U>(item);
+                        slot.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false;
+                }
+                else {
+                    pos = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Moves as many of `items`, from the front, as there are free slots in a row
+        // for; returns how many
+        usize TryPushBatch(std::span<T> items) {
+            // A zero count below means "full or contended", which an empty span can't tell apart
+            if (items.empty()) {
+                return 0;
+            }
+            usize pos = m_tail.load(std::memory_order_relaxed);
+            while (true) {
+                const usize count = CountInTurn(pos, 0, items.size());
+                if (count == 0) {
+                    if (static_cast<i64>(m_slots[pos & m_mask].sequence.load(std::memory_order_acquire) - pos) < 0) {
+                        return 0;
+                    }
+                    pos = m_tail.load(std::memory_order_relaxed);
+                    continue;
+                }
+                if (m_tail.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                    for (usize i = 0; i < count; ++i) {
+                        Slot& slot = m_slots[(pos + i) & m_mask];
+                        slot.value = std::move(items[i]);
+                        slot.sequence.store(pos + i + 1, std::memory_order_release);
+                    }
+                    return count;
+                }
+            }
+        }
+
+        bool TryPop(T& out) {
+            usize pos = m_head.load(std::memory_order_relaxed);
+            while (true) {
+                Slot& slot = m_slots[pos & m_mask];
+                const i64 diff = static_cast<i64>(slot.sequence.load(std::memory_order_acquire) - (pos + 1));
+                if (diff == 0) {
+                    if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        out = std::move(slot.value);
+                        slot.sequence.store(pos + m_slots.size(), std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false;
+                }
+                else {
+                    pos = m_head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        usize TryPopBatch(std::span<T> out) {
+            if (out.empty()) {
+                return 0;
+            }
+            usize pos = m_head.load(std::memory_order_relaxed);
+            while (true) {
+                const usize count = CountInTurn(pos, 1, out.size());
+                if (count == 0) {
+                    if (static_cast<i64>(m_slots[pos & m_mask].sequence.load(std::memory_order_acquire) - (pos + 1)) < 0) {
+                        return 0;
+                    }
+                    pos = m_head.load(std::memory_order_relaxed);
+                    continue;
+                }
+                if (m_head.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                    for (usize i = 0; i < count; ++i) {
+                        Slot& slot = m_slots[(pos + i) & m_mask];
+                        out[i] = std::move(slot.value);
+                        slot.sequence.store(pos + i + m_slots.size(), std::memory_order_release);
+                    }
+                    return count;
+                }
+            }
+        }
+
+        usize SizeApprox() const {
+            const i64 size = static_cast<i64>(m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire));
+            return static_cast<usize>(std::max<i64>(size, 0));
+        }
+
+    private:
+        struct Slot {
+            std::atomic<usize> sequence{ 0 };
+            T value{};
+        };
+
+        // Slots from `pos` on whose sequence is position + offset, up to `limit`
+        usize CountInTurn(usize pos, usize offset, usize limit) const {
+            usize count = 0;
+            while (count < limit && m_slots[(pos + count) & m_mask].sequence.load(std::memory_order_acquire) == pos + count + offset) {
+                ++count;
+            }
+            return count;
+        }
+
+        std::vector<Slot> m_slots;
+        usize m_mask;
+        alignas(CACHE_LINE_SIZE) std::atomic<usize> m_head{ 0 };
+        alignas(CACHE_LINE_SIZE) std::atomic<usize> m_tail{ 0 };
+    };
+
+    // A logical CPU and where it sits. core/cache/package are keys for comparing CPUs,
+    // not OS indices.
+    struct CpuInfo {
+        u32 id = 0;         // OS CPU number
+        u32 core = 0;       // Physical core
+        u32 cache = 0;      // Last-level cache domain
+        u32 package = 0;    // Socket
+        u32 smt_index = 0;  // Position among the core's hardware threads
+    };
+
+    // CPU layout, read once from /sys/devices/system/cpu. Where that isn't available
+    // every CPU hardware_concurrency() reports is treated as its own core on a single
+    // package, so the placement code still works, just without topology.
+    class CpuTopology {
+    public:
+        static const CpuTopology& Get() {
+            static const CpuTopology s_topology;
+            return s_topology;
+        }
+
+        const std::vector<CpuInfo>& GetCpus() const {
+            return m_cpus;
+        }
+
+        const CpuInfo* Find(u32 id) const {
+            for (const CpuInfo& cpu : m_cpus) {
+                if (cpu.id == id) {
+                    return &cpu;
+                }
+            }
+            return nullptr;
+        }
+
+        // CPUs not in `exclude`, in the order workers should take them: one hardware
+        // thread per core before any SMT sibling, and cores sharing a cache together
+        std::vector<u32> PlacementOrder(std::span<const u32> exclude) const {
+            std::vector<const CpuInfo*> eligible;
+            for (const CpuInfo& cpu : m_cpus) {
+                if (std::find(exclude.begin(), exclude.end(), cpu.id) == exclude.end()) {
+                    eligible.push_back(&cpu);
+                }
+            }
+            std::sort(eligible.begin(), eligible.end(), [](const CpuInfo* a, const CpuInfo* b) {
+                return std::tie(a->smt_index, a->package, a->cache, a->core, a->id)
+                    < std::tie(b->smt_index, b->package, b->cache, b->core, b->id);
+                });
+            std::vector<u32> order;
+            for (const CpuInfo* cpu : eligible) {
+                order.push_back(cpu->id);
+            }
+            return order;
+        }
+
+        // 0: SMT siblings, 1: shared last-level cache, 2: same package, 3: further apart
+        static u32 Distance(const CpuInfo& a, const CpuInfo& b) {
+            if (a.core == b.core) {
+                return 0;
+            }
+            if (a.cache == b.cache) {
+                return 1;
+            }
+            return a.package == b.package ? 2 : 3;
+        }
+
+        // Parses sysfs CPU lists such as "0-3,8,10-11"
+        static std::vector<u32> ParseCpuList(std::string_view list) {
+            std::vector<u32> cpus;
+            while (!list.empty()) {
+                const usize comma = list.find(',');
+                const std::string_view range = list.substr(0, comma);
+                list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+                const usize dash = range.find('-');
+                const std::optional<u32> first = ParseU32(range.substr(0, dash));
+                const std::optional<u32> last = dash == std::string_view::npos ? first : ParseU32(range.substr(dash + 1));
+                if (!first || !last) {
+                    continue;
+                }
+                for (u32 cpu = *first; cpu <= *last; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            }
+            return cpus;
+        }
+
+    private:
+        CpuTopology() {
+            namespace fs = std::filesystem;
+            const fs::path root = "/sys/devices/system/cpu";
+            std::vector<u32> online;
+            if (std::optional<std::string> list = ReadLine(root / "online")) {
+                online = ParseCpuList(*list);
+            }
+
+            for (u32 id : online) {
+                const fs::path cpu = root / ("cpu" + std::to_string(id));
+                CpuInfo info;
+                info.id = id;
+                info.package = ReadU32(cpu / "topology" / "physical_package_id").value_or(0);
+                // core_id is only unique within a package
+                info.core = (info.package << 16) | ReadU32(cpu / "topology" / "core_id").value_or(id);
+                info.cache = 0x80000000u | info.package; // No L3 found: the package stands in
+                for (u32 index = 0;; ++index) {
+                    const fs::path cache = cpu / "cache" / ("index" + std::to_string(index));
+                    const std::optional<u32> level = ReadU32(cache / "level");
+                    if (!level) {
+                        break;
+                    }
+                    if (*level == 3) {
+                        if (std::optional<std::string> shared = ReadLine(cache / "shared_cpu_list")) {
+                            const std::vector<u32> sharing = ParseCpuList(*shared);
+                            if (!sharing.empty()) {
+                                info.cache = sharing.front();
+                            }
+                        }
+                    }
+                }
+                m_cpus.push_back(info);
+            }
+
+            if (m_cpus.empty()) {
+                const u32 count = std::max(1u, std::thread::hardware_concurrency());
+                for (u32 id = 0; id < count; ++id) {
+                    m_cpus.push_back({ id, id, 0, 0, 0 });
+                }
+            }
+
+            std::unordered_map<u32, u32> threads_per_core;
+            for (CpuInfo& cpu : m_cpus) {
+                cpu.smt_index = threads_per_core[cpu.core]++;
+            }
+        }
+
+        static std::optional<u32> ParseU32(std::string_view text) {
+            u32 value = 0;
+            const char* end = text.data() + text.size();
+            const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+            if (ec != std::errc() || ptr == text.data()) {
+                return std::nullopt;
+            }
+            return value;
+        }
+
+        static std::optional<std::string> ReadLine(const std::filesystem::path& path) {
+            std::ifstream file(path);
+            std::string line;
+            if (!file || !std::getline(file, line)) {
+                return std::nullopt;
+            }
+            return line;
+        }
+
+        static std::optional<u32> ReadU32(const std::filesystem::path& path) {
+            const std::optional<std::string> line = ReadLine(path);
+            return line ? ParseU32(*line) : std::nullopt;
+        }
+
+        std::vector<CpuInfo> m_cpus;
+    };
+
+    // Restricts the calling thread to `cpus`. Returns false where unsupported (only
+    // Linux is implemented) or when the OS refuses.
+    inline bool SetCurrentThreadAffinity(std::span<const u32> cpus) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (u32 cpu : cpus) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpus;
+        return false;
+#endif
+    }
+
+    // Names the calling thread for debuggers and profilers. Linux keeps 15 characters.
+    inline void SetCurrentThreadName(std::string_view name) {
+#if defined(__linux__)
+        char buffer[16] = {};
+        name.copy(buffer, sizeof(buffer) - 1);
+        pthread_setname_np(pthread_self(), buffer);
+#else
+        (void)name;
+#endif
+    }
+
+    struct ThreadPoolOptions {
+        usize thread_count = std::thread::hardware_concurrency();
+        // CPUs kept free of workers, e.g. for the main and render threads. The caller
+        // pins those threads itself (SetCurrentThreadAffinity).
+        std::vector<u32> reserved_cpus;
+        // Pin each worker to one CPU, spread over physical cores first (see
+        // CpuTopology::PlacementOrder), and steal from nearby workers first. Without it
+        // workers float over the non-reserved CPUs.
+        bool pin_workers = false;
+        // Workers are named "<thread_name>-<slot>"
+        std::string thread_name = "spark-worker";
+    };
+
+    // Handle to a timer from ThreadPool::EnqueueAfter/EnqueueEvery. Stale handles are
+    // detected by generation, so cancelling a timer that already fired is a no-op.
+    struct TimerId {
+        u32 index = std::numeric_limits<u32>::max();
+        u32 generation = 0;
+
+        bool Valid() const {
+            return index != std::numeric_limits<u32>::max();
+        }
+    };
+
+    // Hierarchical timing wheel (Varghese & Lauck) over integer ticks: 256 one-tick
+    // slots, then three levels of 64 slots each covering 64 times the span of the one
+    // below, so about 2^26 ticks ahead. Farther deadlines wait in the top level and
+    // are re-placed each time it comes round. Timers are nodes in a free-listed
+    // vector linked into their slot, so adding and cancelling are O(1) with no
+    // allocation once the vector has grown; a node moves down a level at most three
+    // times before it fires. Not thread-safe.
+    template <typename T>
+    class TimerWheel {
+    public:
+        // Timers at or before CurrentTick() fire on the next Advance
+        u64 CurrentTick() const {
+            return m_current;
+        }
+
+        usize Size() const {
+            return m_size;
+        }
+
+        TimerId Add(u64 deadline, T value) {
+            u32 index;
+            if (m_free != INVALID) {
+                index = m_free;
+                m_free = m_nodes[index].next;
+            }
+            else {
+                index = static_cast<u32>(m_nodes.size());
+                m_nodes.emplace_back();
+            }
+            Node& node = m_nodes[index];
+            node.deadline = deadline;
+            node.live = true;
+            node.value = std::move(value);
+            Link(index);
+            ++m_size;
+            return { index, node.generation };
+        }
+
+        // The cancelled timer's value, or nullopt if the id is stale
+        std::optional<T> Cancel(TimerId id) {
+            if (id.index >= m_nodes.size() || !m_nodes[id.index].live || m_nodes[id.index].generation != id.generation) {
+                return std::nullopt;
+            }
+            Unlink(id.index);
+            std::optional<T> value(std::move(m_nodes[id.index].value));
+            Free(id.index);
+            return value;
+        }
+
+        // Fires every timer due at or before `now` in deadline order (ties in no
+        // particular order). on_expire(T&, deadline) returns the next deadline to keep
+        // the timer (a periodic one), or 0 to drop it. It may Add timers but not Cancel.
+        template <typename Fn>
+        void Advance(u64 now, Fn&& on_expire) {
+            while (m_current <= now) {
+                const u64 tick = m_current;
+                const u32 slot = static_cast<u32>(tick & (LEVEL0_SLOTS - 1));
+                if (slot == 0) {
+                    Cascade(tick);
+                }
+                u32 list = m_heads[slot];
+                m_heads[slot] = INVALID;
+                m_occupied[slot / 64] &= ~(u64(1) << (slot % 64));
+                m_current = tick + 1;
+
+                while (list != INVALID) {
+                    const u32 index = list;
+                    list = m_nodes[index].next;
+                    m_nodes[index].bucket = INVALID;
+                    // Held outside the node: an Add from on_expire may grow m_nodes
+                    T value = std::move(m_nodes[index].value);
+                    const u64 next = on_expire(value, m_nodes[index].deadline);
+                    if (next == 0) {
+                        Free(index);
+                    }
+                    else {
+                        m_nodes[index].value = std::move(value);
+                        m_nodes[index].deadline = next;
+                        Link(index);
+                    }
+                }
+            }
+        }
+
+        // A tick worth waking up for: the earliest occupied one-tick slot in the current
+        // 256-tick block, else the next block boundary, where upper levels cascade.
+        // nullopt when no timers are pending.
+        std::optional<u64> NextTick() const {
+            if (m_size == 0) {
+                return std::nullopt;
+            }
+            const u32 start = static_cast<u32>(m_current & (LEVEL0_SLOTS - 1));
+            if (start == 0) {
+                return m_current; // This block's cascade hasn't run yet
+            }
+            for (u32 word = start / 64; word < LEVEL0_SLOTS / 64; ++word) {
+                u64 bits = m_occupied[word];
+                if (word == start / 64) {
+                    bits &= ~u64(0) << (start % 64);
+                }
+                if (bits != 0) {
+                    return (m_current & ~u64(LEVEL0_SLOTS - 1)) + word * 64 + std::countr_zero(bits);
+                }
+            }
+            return (m_current | (LEVEL0_SLOTS - 1)) + 1;
+        }
+
+        // Calls fn(T&) on every pending timer and removes them all
+        template <typename Fn>
+        void Clear(Fn&& fn) {
+            for (u32 index = 0; index < m_nodes.size(); ++index) {
+                if (m_nodes[index].live) {
+                    fn(m_nodes[index].value);
+                }
+            }
+            m_nodes.clear();
+            m_heads.fill(INVALID);
+            m_occupied.fill(0);
+            m_free = INVALID;
+            m_size = 0;
+        }
+
+    private:
+        static constexpr u32 INVALID = std::numeric_limits<u32>::max();
+        static constexpr u32 LEVEL0_BITS = 8;
+        static constexpr u32 LEVEL_BITS = 6;
+        static constexpr u32 UPPER_LEVELS = 3;
+        static constexpr u32 LEVEL0_SLOTS = 1u << LEVEL0_BITS;
+        static constexpr u32 LEVEL_SLOTS = 1u << LEVEL_BITS;
+        static constexpr u64 MAX_SPAN = u64(1) << (LEVEL0_BITS + UPPER_LEVELS * LEVEL_BITS);
+
+        struct Node {
+            u64 deadline = 0;
+            u32 prev = INVALID;
+            u32 next = INVALID;   // Also the free-list link
+            u32 bucket = INVALID; // Index into m_heads while linked
+            u32 generation = 0;
+            bool live = false;
+            T value{};
+        };
+
+        static u32 LevelShift(u32 level) {
+            return LEVEL0_BITS + (level - 1) * LEVEL_BITS;
+        }
+
+        void Link(u32 index) {
+            Node& node = m_nodes[index];
+            const u64 deadline = std::max(node.deadline, m_current);
+            const u64 delta = deadline - m_current;
+            u32 bucket;
+            if (delta < LEVEL0_SLOTS) {
+                bucket = static_cast<u32>(deadline & (LEVEL0_SLOTS - 1));
+                m_occupied[bucket / 64] |= u64(1) << (bucket % 64);
+            }
+            else {
+                u32 level = 1;
+                while (level < UPPER_LEVELS && delta >= (u64(1) << LevelShift(level + 1))) {
+                    ++level;
+                }
+                // Beyond the top level's reach: park in its last slot and re-place later
+                const u64 placed = delta < MAX_SPAN ? deadline : m_current + MAX_SPAN - 1;
+                bucket = LEVEL0_SLOTS + (level - 1) * LEVEL_SLOTS
+                    + static_cast<u32>((placed >> LevelShift(level)) & (LEVEL_SLOTS - 1));
+            }
+            node.bucket = bucket;
+            node.prev = INVALID;
+            node.next = m_heads[bucket];
+            if (node.next != INVALID) {
+                m_nodes[node.next].prev = index;
+            }
+            m_heads[bucket] = index;
+        }
+
+        void Unlink(u32 index) {
+            Node& node = m_nodes[index];
+            if (node.bucket == INVALID) {
+                return;
+            }
+            if (node.prev != INVALID) {
+                m_nodes[node.prev].next = node.next;
+            }
+            else {
+                m_heads[node.bucket] = node.next;
+                if (node.next == INVALID && node.bucket < LEVEL0_SLOTS) {
+                    m_occupied[node.bucket / 64] &= ~(u64(1) << (node.bucket % 64));
+                }
+            }
+            if (node.next != INVALID) {
+                m_nodes[node.next].prev = node.prev;
+            }
+            node.bucket = INVALID;
+        }
+
+        void Free(u32 index) {
+            Node& node = m_nodes[index];
+            node.live = false;
+            node.value = T{};
+            ++node.generation;
+            node.bucket = INVALID;
+            node.next = m_free;
+            m_free = index;
+            --m_size;
+        }
+
+        // At a 256-tick boundary, re-place the level 1 slot that has just come into
+        // range, and likewise up the levels whenever a lower one wraps
+        void Cascade(u64 tick) {
+            for (u32 level = 1; level <= UPPER_LEVELS; ++level) {
+                const u32 slot = static_cast<u32>((tick >> LevelShift(level)) & (LEVEL_SLOTS - 1));
+                const u32 bucket = LEVEL0_SLOTS + (level - 1) * LEVEL_SLOTS + slot;
+                u32 list = m_heads[bucket];
+                m_heads[bucket] = INVALID;
+                while (list != INVALID) {
+                    const u32 index = list;
+                    list = m_nodes[index].next;
+                    Link(index);
+                }
+                if (slot != 0) {
+                    break;
+                }
+            }
+        }
+
+        std::vector<Node> m_nodes;
+        std::array<u32, LEVEL0_SLOTS + UPPER_LEVELS * LEVEL_SLOTS> m_heads = MakeHeads();
+        std::array<u64, LEVEL0_SLOTS / 64> m_occupied{};  // Non-empty one-tick slots
+        u32 m_free = INVALID;
+        usize m_size = 0;
+        u64 m_current = 0;
+
+        static std::array<u32, LEVEL0_SLOTS + UPPER_LEVELS * LEVEL_SLOTS> MakeHeads() {
+            std::array<u32, LEVEL0_SLOTS + UPPER_LEVELS * LEVEL_SLOTS> heads;
+            heads.fill(INVALID);
+            return heads;
+        }
+    };
+
+    namespace detail {
+        struct SlicedJobState {
+            std::function<bool()> step;   // True while there is more to do
+            std::atomic<bool> done{ false };
+            std::atomic<bool> cancelled{ false };
+            std::exception_ptr error;     // Set before done
+        };
+    }
+
+    // Shared handle to a job started with ThreadPool::EnqueueSliced
+    class SlicedJobHandle {
+    public:
+        SlicedJobHandle() = default;
+
+        explicit SlicedJobHandle(std::shared_ptr<detail::SlicedJobState> state)
+            : m_state(std::move(state)) {
+        }
+
+        bool Valid() const {
+            return m_state != nullptr;
+        }
+
+        // Finished, failed or cancelled
+        bool IsDone() const {
+            return m_state->done.load(std::memory_order_acquire);
+        }
+
+        // The job stops before its next slice; a slice already running completes
+        void Cancel() {
+            m_state->cancelled.store(true, std::memory_order_relaxed);
+        }
+
+        // Rethrows what a slice threw, once the job is done
+        void Check() const {
+            if (IsDone() && m_state->error) {
+                std::rethrow_exception(m_state->error);
+            }
+        }
+
+    private:
+        std::shared_ptr<detail::SlicedJobState> m_state;
+    };
+
+    // Optional policy for ThreadPool::EnableAutoScale. A monitor thread samples the pool
+    // every sample_interval: it adds a worker while more than grow_queue_depth tasks
+    // per worker are waiting, and retires one after workers have sat parked with
+    // nothing queued for shrink_idle_time.
+    struct AutoScalePolicy {
+        usize min_threads = 1;
+        usize max_threads = std::thread::hardware_concurrency();
+        usize grow_queue_depth = 4;
+        std::chrono::milliseconds shrink_idle_time{ 2000 };
+        std::chrono::milliseconds sample_interval{ 50 };
+    };
+
+    // One worker's counters, cumulative since the worker slot was first used
+    struct WorkerStats {
+        u64 tasks_executed = 0;
+        u64 tasks_stolen = 0;     // Taken from another worker's deques
+        u64 failed_steals = 0;    // Steal attempts that came back empty
+        u64 busy_ns = 0;          // Running tasks
+        u64 parked_ns = 0;        // Asleep waiting for work
+        u64 max_queue_depth = 0;  // Most tasks seen in the worker's own deques
+
+        WorkerStats& operator+=(const WorkerStats& other) {
+            tasks_executed += other.tasks_executed;
+            tasks_stolen += other.tasks_stolen;
+            failed_steals += other.failed_steals;
+            busy_ns += other.busy_ns;
+            parked_ns += other.parked_ns;
+            max_queue_depth = std::max(max_queue_depth, other.max_queue_depth);
+            return *this;
+        }
+    };
+
+    // Snapshot from ThreadPool::GetStats
+    struct PoolStats {
+        std::vector<WorkerStats> workers;  // Indexed by worker slot
+        usize injected_queue_depth = 0;    // Tasks waiting in the injection queue when taken
+
+        WorkerStats Total() const {
+            WorkerStats total;
+            for (const WorkerStats& worker : workers) {
+                total += worker;
+            }
+            return total;
+        }
+
+        // Counters accumulated since `earlier`, e.g. over one frame. Depths are kept
+        // as they are, being high-water marks rather than counts.
+        PoolStats Since(const PoolStats& earlier) const {
+            PoolStats delta = *this;
+            for (usize i = 0; i < std::min(workers.size(), earlier.workers.size()); ++i) {
+                WorkerStats& d = delta.workers[i];
+                const WorkerStats& e = earlier.workers[i];
+                d.tasks_executed -= std::min(d.tasks_executed, e.tasks_executed);
+                d.tasks_stolen -= std::min(d.tasks_stolen, e.tasks_stolen);
+                d.failed_steals -= std::min(d.failed_steals, e.failed_steals);
+                d.busy_ns -= std::min(d.busy_ns, e.busy_ns);
+                d.parked_ns -= std::min(d.parked_ns, e.parked_ns);
+            }
+            return delta;
+        }
+
+        // One line per worker
+        std::string ToString() const {
+            std::string out;
+            char line[192];
+            for (usize i = 0; i < workers.size(); ++i) {
+                const WorkerStats& w = workers[i];
+                std::snprintf(line, sizeof(line),
+                    "worker %zu: %llu tasks, %llu stolen, %llu failed steals, busy %.2f ms, parked %.2f ms, max depth %llu\n",
+                    i, static_cast<unsigned long long>(w.tasks_executed), static_cast<unsigned long long>(w.tasks_stolen),
+                    static_cast<unsigned long long>(w.failed_steals), w.busy_ns / 1e6, w.parked_ns / 1e6,
+                    static_cast<unsigned long long>(w.max_queue_depth));
+                out += line;
+            }
+            std::snprintf(line, sizeof(line), "injected queue depth: %zu\n", injected_queue_depth);
+            out += line;
+            return out;
+        }
+    };
+
     // ThreadPool Class
+    //
+    // Every worker owns one WorkStealingDeque per TaskPriority. Tasks enqueued from a
+    // worker go to its own deques; tasks from any other thread go to a shared injection
+    // queue, also split by priority. Each set of queues keeps a bitmask of its
+    // non-empty levels, so picking the highest priority is a bit scan rather than a
+    // search. An idle worker takes the best level from its deques or the injection
+    // queue, then steals from the others, and finally parks on an atomic epoch
+    // counter that every enqueue bumps. BACKGROUND work is guaranteed at least one
+    // pick in every BACKGROUND_INTERVAL while a worker can see some queued.
     class ThreadPool {
     public:
+        // Upper bound on workers alive at once; slots are reused after RemoveThreads
+        static constexpr usize MAX_WORKERS = 256;
+
         // Constructor: Initializes the pool with the specified number of threads
         ThreadPool(usize num_threads = std::thread::hardware_concurrency())
-            : m_stop(false), m_active_tasks(0), m_rng(std::random_device{}()) {
-            Initialize(num_threads);
+            : ThreadPool(OptionsWithThreads(num_threads)) {
+        }
+
+        explicit ThreadPool(const ThreadPoolOptions& options)
+            : m_thread_name(options.thread_name), m_pin_workers(options.pin_workers), m_stop(false), m_active_tasks(0) {
+            if (options.pin_workers || !options.reserved_cpus.empty()) {
+                const CpuTopology& topology = CpuTopology::Get();
+                for (u32 id : topology.PlacementOrder(options.reserved_cpus)) {
+                    m_worker_cpus.push_back(*topology.Find(id));
+                }
+            }
+            Initialize(options.thread_count);
+        }
+
+        ~ThreadPool() {
+            Shutdown();
+            Task* task = nullptr;
+            for (usize i = 0; i < MAX_WORKERS; ++i) {
+                if (m_workers[i]) {
+                    for (auto& deque : m_workers[i]->deques) {
+                        while (deque.Pop(task)) {
+                            Task::Discard(task);
+                        }
+                    }
+                }
+            }
+            for (auto& queue : m_injected) {
+                for (Task* t : queue) {
+                    Task::Discard(t);
+                }
+            }
+        }
+
+        // Prevent copy and assignment
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Fire-and-forget: runs f() on the pool. The callable is stored inline in a
+        // pooled task block, so small lambdas are submitted without heap allocation.
+        // Exceptions thrown by f are dropped; use Spawn to observe them.
+        template <class F>
+        void Submit(TaskPriority priority, F&& f) {
+            Push(Task::Create(priority, std::forward<F>(f)));
+        }
+
+        // Like Submit, but returns a TaskHandle for the result. The shared state comes
+        // from the same block pools when the result type is small.
+        template <class F>
+        TaskHandle<std::invoke_result_t<std::decay_t<F>&>> Spawn(TaskPriority priority, F&& f) {
+            using return_type = std::invoke_result_t<std::decay_t<F>&>;
+            detail::TaskState<return_type>* state = detail::CreateTaskState<return_type>();
+            TaskHandle<return_type> handle(state);
+
+            state->pool = this;
+            state->priority = priority;
+
+            Task* task = Task::Create(priority, [this, state, fn = std::forward<F>(f)]() mutable {
+                try {
+                    if constexpr (std::is_void_v<return_type>) {
+                        fn();
+                    }
+                    else {
+                        state->value.emplace(fn());
+                    }
+                }
+                catch (...) {
+                    state->error = std::current_exception();
+                }
+                state->Finish();
+                NotifyWaiters();
+                state->Release();
+                });
+            try {
+                Push(task);
+            }
+            catch (...) {
+                state->Release(); // the task's reference
+                throw;
+            }
+            return handle;
+        }
+
+        // `co_await pool.Schedule()` moves the rest of a coroutine onto the pool
+        struct ScheduleAwaiter {
+            ThreadPool& pool;
+            TaskPriority priority;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                pool.Submit(priority, [handle]() { handle.resume(); });
+            }
+            void await_resume() const noexcept {}
+        };
+
+        ScheduleAwaiter Schedule(TaskPriority priority = TaskPriority::NORMAL) {
+            return { *this, priority };
+        }
+
+        // Enqueue a task with a specified priority
+        // Returns a TaskResult whose future holds the task's return value
+        template<class F, class... Args>
+        TaskResult<typename std::invoke_result<F, Args...>::type> Enqueue(TaskPriority priority, F&& f, Args&&... args) {
+            using return_type = typename std::invoke_result<F, Args...>::type;
+
+            std::packaged_task<return_type()> task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+
+            TaskResult<return_type> task_result;
+            task_result.result = task.get_future();
+            Push(Task::Create(priority, std::move(task)));
+            return task_result;
+        }
+
+        // Enqueue that also reports which thread ran the task through TaskResult::thread_id.
+        // Costs an extra promise per task, so it is opt-in.
+        template<class F, class... Args>
+        TaskResult<typename std::invoke_result<F, Args...>::type> EnqueueWithThreadId(TaskPriority priority, F&& f, Args&&... args) {
+            using return_type = typename std::invoke_result<F, Args...>::type;
+
+            std::packaged_task<return_type()> task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+            std::promise<std::thread::id> thread_id_promise;
+
+            TaskResult<return_type> task_result;
+            task_result.result = task.get_future();
+            task_result.thread_id = thread_id_promise.get_future();
+
+            Push(Task::Create(priority, [task = std::move(task), thread_id_promise = std::move(thread_id_promise)]() mutable {
+                task();
+                thread_id_promise.set_value(std::this_thread::get_id());
+                }));
+            return task_result;
+        }
+
+        // Granularity of EnqueueAfter/EnqueueEvery
+        static constexpr std::chrono::milliseconds TIMER_TICK{ 1 };
+
+        // Runs f once on the pool after `delay`, rounded up to a whole TIMER_TICK so it
+        // never runs early. Timers are kept by a dedicated thread on a TimerWheel, started
+        // with the first one; pending timers don't count towards WaitForAllTasks.
+        template <class Rep, class Period, class F>
+        TimerId EnqueueAfter(std::chrono::duration<Rep, Period> delay, TaskPriority priority, F&& f) {
+            TimerEntry entry;
+            entry.once = Task::Create(priority, std::forward<F>(f));
+            entry.priority = priority;
+            return AddTimer(DeadlineAfter(delay), std::move(entry));
+        }
+
+        // Runs f every `period` at a fixed rate until CancelTimer, the first time one
+        // period from now. If the pool falls more than a period behind, missed runs
+        // are skipped rather than bunched up.
+        template <class Rep, class Period, class F>
+        TimerId EnqueueEvery(std::chrono::duration<Rep, Period> period, TaskPriority priority, F&& f) {
+            TimerEntry entry;
+            entry.repeat = std::make_shared<std::function<void()>>(std::forward<F>(f));
+            entry.period = std::max<u64>(1, TicksCeil(period));
+            entry.priority = priority;
+            return AddTimer(DeadlineAfter(period), std::move(entry));
+        }
+
+        // False if the timer already fired (one-shot) or was cancelled before. A run
+        // already handed to the pool still completes.
+        bool CancelTimer(TimerId id) {
+            std::optional<TimerEntry> entry;
+            {
+                std::lock_guard<std::mutex> lock(m_timer_mutex);
+                entry = m_timers.Cancel(id);
+            }
+            if (!entry) {
+                return false;
+            }
+            if (entry->once) {
+                Task::Discard(entry->once);
+            }
+            return true;
+        }
+
+        usize GetPendingTimerCount() {
+            std::lock_guard<std::mutex> lock(m_timer_mutex);
+            return m_timers.Size();
+        }
+
+        // Long background work (navmesh baking, lightmap compression) cut into slices so it
+        // never holds a worker through a frame. `step` does a bounded chunk, well under a
+        // millisecond, and returns true while there's more. Slices run only while no
+        // CRITICAL..NORMAL task is queued anywhere in the pool, take turns with LOW and
+        // below, and stop for the frame once the slice budget is spent. Jobs take turns
+        // slice by slice. They don't count towards WaitForAllTasks; pending ones are
+        // dropped on Shutdown.
+        template <typename F>
+        SlicedJobHandle EnqueueSliced(F&& step) {
+            auto state = std::make_shared<detail::SlicedJobState>();
+            state->step = std::forward<F>(step);
+            {
+                std::lock_guard<std::mutex> lock(m_sliced_mutex);
+                if (m_stop.load()) {
+                    throw std::runtime_error("Enqueue on stopped ThreadPool");
+                }
+                m_sliced_jobs.push_back(state);
+                m_sliced_pending.store(m_sliced_jobs.size(), std::memory_order_relaxed);
+            }
+            WakeWorkers(false);
+            return SlicedJobHandle(std::move(state));
+        }
+
+        // Worker time all slices together may take per frame; zero, the default, leaves
+        // them unbudgeted. A slice that starts within budget runs to its end, so steps
+        // should stay short.
+        void SetSliceBudget(std::chrono::nanoseconds budget) {
+            m_slice_budget.store(budget.count(), std::memory_order_relaxed);
+            BeginSliceFrame();
+        }
+
+        // Refills the slice budget. Application::Run calls it at the start of each frame.
+        void BeginSliceFrame() {
+            const i64 budget = m_slice_budget.load(std::memory_order_relaxed);
+            m_slice_remaining.store(budget > 0 ? budget : UNBUDGETED, std::memory_order_relaxed);
+            if (m_sliced_pending.load(std::memory_order_relaxed) != 0) {
+                WakeWorkers(true);
+            }
+        }
+
+        // Add more worker threads to the pool
+        void AddThreads(usize count) {
+            std::lock_guard<std::mutex> lock(m_resize_mutex);
+            GrowLocked(count);
+        }
+
+        // Remove worker threads from the pool, newest first. Each one finishes the task
+        // it is running, hands whatever is left in its deques to the injection queue and
+        // exits; the others keep working throughout. Blocks until the removed threads
+        // have exited, so it can't be called from one of this pool's workers.
+        void RemoveThreads(usize count) {
+            std::lock_guard<std::mutex> lock(m_resize_mutex);
+            ShrinkLocked(count);
+        }
+
+        // Grows or shrinks the pool to `count` workers. The current size is read under
+        // the resize lock, so a concurrent auto-scaler step can't skew the result.
+        void SetThreadCount(usize count) {
+            std::lock_guard<std::mutex> lock(m_resize_mutex);
+            const usize current = m_worker_count.load(std::memory_order_relaxed);
+            if (count > current) {
+                GrowLocked(count - current);
+            }
+            else if (count < current) {
+                ShrinkLocked(current - count);
+            }
+        }
+
+        usize GetThreadCount() const {
+            return m_worker_count.load(std::memory_order_acquire);
+        }
+
+        // Per-worker counters are only collected while enabled; when disabled the cost
+        // is one relaxed load per task
+        void EnableTelemetry(bool enabled = true) {
+            m_telemetry.store(enabled, std::memory_order_relaxed);
+        }
+
+        bool IsTelemetryEnabled() const {
+            return m_telemetry.load(std::memory_order_relaxed);
+        }
+
+        PoolStats GetStats() {
+            PoolStats stats;
+            const usize count = GetThreadCount();
+            stats.workers.resize(count);
+            for (usize i = 0; i < count; ++i) {
+                const WorkerCounters& c = m_workers[i]->counters;
+                WorkerStats& w = stats.workers[i];
+                w.tasks_executed = c.tasks_executed.load(std::memory_order_relaxed);
+                w.tasks_stolen = c.tasks_stolen.load(std::memory_order_relaxed);
+                w.failed_steals = c.failed_steals.load(std::memory_order_relaxed);
+                w.busy_ns = c.busy_ns.load(std::memory_order_relaxed);
+                w.parked_ns = c.parked_ns.load(std::memory_order_relaxed);
+                w.max_queue_depth = c.max_queue_depth.load(std::memory_order_relaxed);
+            }
+            std::lock_guard<std::mutex> lock(m_inject_mutex);
+            for (const auto& queue : m_injected) {
+                stats.injected_queue_depth += queue.size();
+            }
+            return stats;
+        }
+
+        // Starts (or retunes) the auto-scaling monitor. The pool is first clamped into
+        // [min_threads, max_threads].
+        void EnableAutoScale(const AutoScalePolicy& policy) {
+            DisableAutoScale();
+            const usize max_threads = std::clamp<usize>(policy.max_threads, 1, MAX_WORKERS);
+            const usize min_threads = std::min(policy.min_threads, max_threads);
+            SetThreadCount(std::clamp(GetThreadCount(), min_threads, max_threads));
+
+            m_scale_policy = policy;
+            m_scale_policy.min_threads = min_threads;
+            m_scale_policy.max_threads = max_threads;
+            m_scale_stop = false;
+            m_scale_thread = std::thread(&ThreadPool::AutoScaleThread, this);
+        }
+
+        void DisableAutoScale() {
+            if (!m_scale_thread.joinable()) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_scale_mutex);
+                m_scale_stop = true;
+            }
+            m_scale_cv.notify_all();
+            m_scale_thread.join();
+        }
+
+        // Wait for all tasks to complete, helping to run them meanwhile
+        void WaitForAllTasks() {
+            WaitUntil([this]() { return m_active_tasks.load(std::memory_order_acquire) == 0; });
+        }
+
+        // Runs one queued task on the calling thread if there is one. A worker looks
+        // where it normally would; any other thread takes from the injection queue,
+        // then steals, and only runs tasks at `lowest` or more urgent.
+        bool TryRunPendingTask(TaskPriority lowest = TaskPriority::BACKGROUND) {
+            Task* task = IsWorkerThread() ? FindTask(t_worker_index) : FindExternalTask(LevelsUpTo(lowest));
+            if (!task) {
+                return false;
+            }
+            RunTask(task);
+            return true;
+        }
+
+        // Blocks until done() is true. The waiting thread runs queued tasks while there
+        // are any and only then sleeps, on an epoch bumped by every enqueue and by
+        // NotifyWaiters(), so it neither polls on a timer nor misses new work. Whatever
+        // makes done() true must call NotifyWaiters() afterwards.
+        //
+        // A thread outside the pool only helps with tasks at `lowest` or more urgent,
+        // so e.g. the main thread waiting on frame work doesn't pick up a long
+        // BACKGROUND job and stall the frame. Workers help with anything.
+        template <typename Pred>
+        void WaitUntil(Pred&& done, TaskPriority lowest = TaskPriority::BACKGROUND) {
+            if (done()) {
+                return;
+            }
+            m_waiters.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst); // Pairs with NotifyWaiters
+
+            u32 idle_rounds = 0;
+            while (!done()) {
+                if (TryRunPendingTask(lowest)) {
+                    idle_rounds = 0;
+                    continue;
+                }
+                if (++idle_rounds < SPIN_ROUNDS) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const u32 epoch = m_waiter_epoch.load(std::memory_order_acquire);
+                if (done()) {
+                    break;
+                }
+                if (TryRunPendingTask(lowest)) {
+                    idle_rounds = 0;
+                    continue;
+                }
+                m_waiter_epoch.wait(epoch, std::memory_order_acquire);
+                idle_rounds = 0;
+            }
+            m_waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // Wakes threads blocked in WaitUntil so they re-check their condition.
+        // Costs a fence and a load when nobody is waiting.
+        void NotifyWaiters() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_waiters.load(std::memory_order_relaxed) != 0) {
+                m_waiter_epoch.fetch_add(1, std::memory_order_release);
+                m_waiter_epoch.notify_all();
+            }
+        }
+
+        // DANGEROUS CALL
+        void Shutdown() {
+            StopTimers();
+            DisableAutoScale();
+            std::lock_guard<std::mutex> lock(m_resize_mutex);
+            m_stop.store(true);
+            WakeWorkers(true);
+
+            for (usize i = 0; i < m_worker_count.load(std::memory_order_relaxed); ++i) {
+                if (m_workers[i]->thread.joinable()) {
+                    m_workers[i]->thread.join();
+                }
+            }
+
+            std::lock_guard<std::mutex> sliced_lock(m_sliced_mutex);
+            for (const auto& job : m_sliced_jobs) {
+                job->done.store(true, std::memory_order_release);
+            }
+            m_sliced_jobs.clear();
+            m_sliced_pending.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr usize PRIORITY_COUNT = static_cast<usize>(TaskPriority::BACKGROUND) + 1;
+        static constexpr u32 BACKGROUND_LEVEL = static_cast<u32>(TaskPriority::BACKGROUND);
+        // A worker that keeps passing over queued BACKGROUND work takes one after this many picks
+        static constexpr u32 BACKGROUND_INTERVAL = 16;
+        // Levels that hold sliced jobs back while anything is queued at them
+        static constexpr u32 FRAME_LEVELS = (1u << (static_cast<u32>(TaskPriority::NORMAL) + 1)) - 1;
+        static constexpr i64 UNBUDGETED = std::numeric_limits<i64>::max();
+
+        // Level bits from CRITICAL down to `lowest`
+        static constexpr u32 LevelsUpTo(TaskPriority lowest) {
+            return (2u << static_cast<u32>(lowest)) - 1;
+        }
+
+        // Written by the owning worker only (plain load + store, no RMW), read by GetStats
+        struct alignas(CACHE_LINE_SIZE) WorkerCounters {
+            std::atomic<u64> tasks_executed{ 0 };
+            std::atomic<u64> tasks_stolen{ 0 };
+            std::atomic<u64> failed_steals{ 0 };
+            std::atomic<u64> busy_ns{ 0 };
+            std::atomic<u64> parked_ns{ 0 };
+            std::atomic<u64> max_queue_depth{ 0 };
+
+            static void Add(std::atomic<u64>& counter, u64 amount) {
+                counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+            }
+        };
+
+        struct alignas(CACHE_LINE_SIZE) Worker {
+            std::array<WorkStealingDeque<Task*>, PRIORITY_COUNT> deques; // Indexed by TaskPriority
+            std::atomic<u32> mask{ 0 };   // Bit per level that may be non-empty; written by the owner only
+            std::thread thread;
+            ThreadControlBlock control;
+            std::atomic<bool> retire{ false };
+            u64 rng_state = 0x9E3779B97F4A7C15ULL; // Victim selection, owner only
+            bool slice_turn = false;               // Alternates slices with tasks, owner only
+            u32 background_skips = 0;              // Owner only
+            WorkerCounters counters;
+        };
+
+        static u64 ElapsedNs(std::chrono::steady_clock::time_point since) {
+            return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - since).count());
+        }
+        // Rounds of empty searching before a worker parks
+        static constexpr u32 SPIN_ROUNDS = 64;
+
+        // Pool and worker slot of the calling thread; t_pool is null off-pool
+        static inline thread_local const ThreadPool* t_pool = nullptr;
+        static inline thread_local usize t_worker_index = 0;
+
+        bool IsWorkerThread() const {
+            return t_pool == this;
+        }
+
+        static ThreadPoolOptions OptionsWithThreads(usize num_threads) {
+            ThreadPoolOptions options;
+            options.thread_count = num_threads;
+            return options;
+        }
+
+        void Push(Task* task) {
+            if (m_stop.load()) {
+                Task::Discard(task);
+                throw std::runtime_error("Enqueue on stopped ThreadPool");
+            }
+
+            m_active_tasks.fetch_add(1, std::memory_order_relaxed);
+            const u32 level = static_cast<u32>(task->priority);
+            if (FRAME_LEVELS & (1u << level)) {
+                m_frame_queued.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (IsWorkerThread()) {
+                Worker& self = *m_workers[t_worker_index];
+                self.deques[level].Push(task);
+                const u32 mask = self.mask.load(std::memory_order_relaxed);
+                if (!(mask & (1u << level))) {
+                    self.mask.store(mask | (1u << level), std::memory_order_release);
+                }
+                if (m_telemetry.load(std::memory_order_relaxed)) {
+                    usize depth = 0;
+                    for (const auto& deque : self.deques) {
+                        depth += deque.Size();
+                    }
+                    if (depth > self.counters.max_queue_depth.load(std::memory_order_relaxed)) {
+                        self.counters.max_queue_depth.store(depth, std::memory_order_relaxed);
+                    }
+                }
+            }
+            else {
+                std::lock_guard<std::mutex> lock(m_inject_mutex);
+                Inject(task);
+            }
+            WakeWorkers(false);
+            NotifyWaiters();
+        }
+
+        // Bumps the epoch so a worker about to park re-checks for work, and wakes
+        // sleepers if there are any
+        void WakeWorkers(bool all) {
+            m_wake_epoch.fetch_add(1, std::memory_order_seq_cst);
+            if (m_sleepers.load(std::memory_order_seq_cst) == 0) {
+                return;
+            }
+            if (all) {
+                m_wake_epoch.notify_all();
+            }
+            else {
+                m_wake_epoch.notify_one();
+            }
+        }
+
+        // Caller holds m_inject_mutex
+        void Inject(Task* task) {
+            const u32 level = static_cast<u32>(task->priority);
+            m_injected[level].push_back(task);
+            m_injected_mask.store(m_injected_mask.load(std::memory_order_relaxed) | (1u << level), std::memory_order_release);
+        }
+
+        // Oldest injected task at `level`, or at the highest non-empty level when
+        // level is PRIORITY_COUNT
+        Task* PopInjected(u32 level = PRIORITY_COUNT) {
+            if (m_injected_mask.load(std::memory_order_acquire) == 0) {
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> lock(m_inject_mutex);
+            const u32 mask = m_injected_mask.load(std::memory_order_relaxed);
+            if (level == PRIORITY_COUNT) {
+                if (mask == 0) {
+                    return nullptr;
+                }
+                level = static_cast<u32>(std::countr_zero(mask));
+            }
+            auto& queue = m_injected[level];
+            if (queue.empty()) {
+                return nullptr;
+            }
+            Task* task = queue.front();
+            queue.pop_front();
+            if (queue.empty()) {
+                m_injected_mask.store(mask & ~(1u << level), std::memory_order_relaxed);
+            }
+            CountTaken(level);
+            return task;
+        }
+
+        void CountTaken(u32 level) {
+            if (FRAME_LEVELS & (1u << level)) {
+                m_frame_queued.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Owner only. Clears the level's bit once its deque turns out to be empty.
+        Task* PopLocal(Worker& self, u32 level) {
+            Task* task = nullptr;
+            if (self.deques[level].Pop(task)) {
+                CountTaken(level);
+                return task;
+            }
+            self.mask.store(self.mask.load(std::memory_order_relaxed) & ~(1u << level), std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        // Picked level first, then the rest from the highest, among the `allowed` levels;
+        // a thief's view of the victim's mask can be stale, which only costs a failed steal
+        Task* StealFrom(Worker& victim, u32& background_skips, u32 allowed = ~0u) {
+            Task* task = nullptr;
+            u32 mask = victim.mask.load(std::memory_order_acquire) & allowed;
+            if (mask == 0) {
+                return nullptr;
+            }
+            const u32 first = PickLevel(background_skips, mask);
+            if (victim.deques[first].Steal(task)) {
+                CountTaken(first);
+                return task;
+            }
+            mask &= ~(1u << first);
+            while (mask != 0) {
+                const u32 level = static_cast<u32>(std::countr_zero(mask));
+                if (victim.deques[level].Steal(task)) {
+                    CountTaken(level);
+                    return task;
+                }
+                mask &= mask - 1;
+            }
+            return nullptr;
+        }
+
+        // Level this worker should serve next out of `pending`: the highest, except that
+        // BACKGROUND gets a turn after BACKGROUND_INTERVAL picks that passed it over
+        static u32 PickLevel(u32& background_skips, u32 pending) {
+            u32 level = static_cast<u32>(std::countr_zero(pending));
+            if (level != BACKGROUND_LEVEL && (pending & (1u << BACKGROUND_LEVEL))) {
+                if (++background_skips < BACKGROUND_INTERVAL) {
+                    return level;
+                }
+                level = BACKGROUND_LEVEL;
+            }
+            background_skips = 0;
+            return level;
+        }
+
+        Task* FindTask(usize index) {
+            Worker& self = *m_workers[index];
+            Task* task = nullptr;
+            const u32 local = self.mask.load(std::memory_order_relaxed);
+            const u32 injected = m_injected_mask.load(std::memory_order_acquire);
+            if ((local | injected) != 0) {
+                const u32 level = PickLevel(self.background_skips, local | injected);
+                if (local & (1u << level)) {
+                    task = PopLocal(self, level);
+                }
+                if (!task && (injected & (1u << level))) {
+                    task = PopInjected(level);
+                }
+                // The masks were stale for that level: take whatever is best now
+                for (u32 left = self.mask.load(std::memory_order_relaxed); !task && left != 0;
+                    left = self.mask.load(std::memory_order_relaxed)) {
+                    task = PopLocal(self, static_cast<u32>(std::countr_zero(left)));
+                }
+                if (task || (task = PopInjected())) {
+                    return task;
+                }
+            }
+
+            // Steal, starting from a random victim so thieves spread out. Pinned workers
+            // go through the victims nearest in the cache hierarchy first.
+            const usize count = m_worker_count.load(std::memory_order_acquire);
+            if (count > 1) {
+                self.rng_state ^= self.rng_state << 13;
+                self.rng_state ^= self.rng_state >> 7;
+                self.rng_state ^= self.rng_state << 17;
+                const usize start = static_cast<usize>(self.rng_state % count);
+                const u32 distances = m_pin_workers && !m_worker_cpus.empty() ? 4 : 1;
+                const bool telemetry = m_telemetry.load(std::memory_order_relaxed);
+                for (u32 distance = 0; distance < distances; ++distance) {
+                    for (usize n = 0; n < count; ++n) {
+                        const usize victim = (start + n) % count;
+                        if (victim == index || (distances > 1 && StealDistance(index, victim) != distance)) {
+                            continue;
+                        }
+                        if ((task = StealFrom(*m_workers[victim], self.background_skips))) {
+                            if (telemetry) {
+                                WorkerCounters::Add(self.counters.tasks_stolen, 1);
+                            }
+                            return task;
+                        }
+                        if (telemetry) {
+                            WorkerCounters::Add(self.counters.failed_steals, 1);
+                        }
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        const CpuInfo& WorkerCpu(usize index) const {
+            return m_worker_cpus[index % m_worker_cpus.size()];
+        }
+
+        u32 StealDistance(usize thief, usize victim) const {
+            return CpuTopology::Distance(WorkerCpu(thief), WorkerCpu(victim));
+        }
+
+        // Runs on the worker itself: name, then pin or keep off the reserved CPUs
+        void PlaceWorker(usize index) {
+            SetCurrentThreadName(m_thread_name + "-" + std::to_string(index));
+            if (m_worker_cpus.empty()) {
+                return;
+            }
+            if (m_pin_workers) {
+                const u32 cpu = WorkerCpu(index).id;
+                SetCurrentThreadAffinity(std::span<const u32>(&cpu, 1));
+            }
+            else {
+                std::vector<u32> allowed;
+                for (const CpuInfo& cpu : m_worker_cpus) {
+                    allowed.push_back(cpu.id);
+                }
+                SetCurrentThreadAffinity(allowed);
+            }
+        }
+
+        // Task search for a thread that isn't one of this pool's workers, limited to
+        // the `allowed` levels
+        Task* FindExternalTask(u32 allowed) {
+            static thread_local usize t_next_victim = 0;
+            static thread_local u32 t_background_skips = 0;
+            Task* task = nullptr;
+            u32 injected = m_injected_mask.load(std::memory_order_acquire) & allowed;
+            if (injected != 0 && (task = PopInjected(PickLevel(t_background_skips, injected)))) {
+                return task;
+            }
+            // Stale pick: take the most urgent allowed level queued now
+            injected = m_injected_mask.load(std::memory_order_acquire) & allowed;
+            if (injected != 0 && (task = PopInjected(static_cast<u32>(std::countr_zero(injected))))) {
+                return task;
+            }
+            const usize count = m_worker_count.load(std::memory_order_acquire);
+            for (usize n = 0; n < count; ++n) {
+                if ((task = StealFrom(*m_workers[t_next_victim++ % count], t_background_skips, allowed))) {
+                    return task;
+                }
+            }
+            return nullptr;
+        }
+
+        void RunTask(Task* task) {
+            if (IsWorkerThread() && m_telemetry.load(std::memory_order_relaxed)) {
+                WorkerCounters::Add(m_workers[t_worker_index]->counters.tasks_executed, 1);
+            }
+            Task::Execute(task);
+            if (m_active_tasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (m_stop.load()) {
+                    // Last task finished during shutdown: let parked workers exit
+                    WakeWorkers(true);
+                }
+                NotifyWaiters();
+            }
         }
 
-        ~ThreadPool() {
-            Shutdown();
+        void RunWorkerTask(Worker& self, Task* task) {
+            if (!m_telemetry.load(std::memory_order_relaxed)) {
+                RunTask(task);
+                return;
+            }
+            const auto started = std::chrono::steady_clock::now();
+            RunTask(task);
+            WorkerCounters::Add(self.counters.busy_ns, ElapsedNs(started));
         }
 
-        // Prevent copy and assignment
-        ThreadPool(const ThreadPool&) = delete;
-        ThreadPool& operator=(const ThreadPool&) = delete;
+        bool FrameWorkQueued() const {
+            return m_frame_queued.load(std::memory_order_relaxed) > 0;
+        }
 
-        // Enqueue a task with a specified priority
-        // Returns a TaskResult containing futures for the result and the executing thread's ID
-        template<class F, class... Args>
-        TaskResult<typename std::invoke_result<F, Args...>::type> Enqueue(TaskPriority priority, F&& f, Args&&... args) {
-            using return_type = typename std::invoke_result<F, Args...>::type;
+        bool SliceRunnable() const {
+            return m_sliced_pending.load(std::memory_order_relaxed) != 0
+                && m_slice_remaining.load(std::memory_order_relaxed) > 0
+                && !FrameWorkQueued();
+        }
 
-            auto task = std::make_shared<std::packaged_task<return_type()>>(
-                std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-            );
+        // Runs one slice of the job at the front and sends it to the back if it has more
+        bool TryRunSlice(Worker& self) {
+            if (!SliceRunnable()) {
+                return false;
+            }
+            std::shared_ptr<detail::SlicedJobState> job;
+            {
+                std::lock_guard<std::mutex> lock(m_sliced_mutex);
+                if (m_sliced_jobs.empty()) {
+                    return false;
+                }
+                job = std::move(m_sliced_jobs.front());
+                m_sliced_jobs.pop_front();
+                m_sliced_pending.store(m_sliced_jobs.size(), std::memory_order_relaxed);
+            }
 
-            TaskResult<return_type> task_result;
-            task_result.result = task->get_future();
+            bool more = false;
+            if (!job->cancelled.load(std::memory_order_relaxed)) {
+                const auto started = std::chrono::steady_clock::now();
+                try {
+                    more = job->step();
+                }
+                catch (...) {
+                    job->error = std::current_exception();
+                }
+                const u64 elapsed = ElapsedNs(started);
+                m_slice_remaining.fetch_sub(static_cast<i64>(elapsed), std::memory_order_relaxed);
+                if (m_telemetry.load(std::memory_order_relaxed)) {
+                    WorkerCounters::Add(self.counters.busy_ns, elapsed);
+                }
+            }
 
-            // Promise to set the thread ID after task execution
-            auto thread_id_promise = std::make_shared<std::promise<std::thread::id>>();
-            task_result.thread_id = thread_id_promise->get_future();
+            if (more && !job->cancelled.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(m_sliced_mutex);
+                m_sliced_jobs.push_back(std::move(job));
+                m_sliced_pending.store(m_sliced_jobs.size(), std::memory_order_relaxed);
+            }
+            else {
+                job->done.store(true, std::memory_order_release);
+            }
+            return true;
+        }
 
-            {
-                std::lock_guard<std::mutex> lock(m_queue_mutex);
+        // Worker thread function
+        void WorkerThread(usize index) {
+            Worker& self = *m_workers[index];
+            t_pool = this;
+            t_worker_index = index;
+            self.control.thread_id = std::this_thread::get_id();
+            PlaceWorker(index);
+            self.rng_state ^= static_cast<u64>(index + 1) * 0xBF58476D1CE4E5B9ULL;
+
+            u32 idle_rounds = 0;
+            while (true) {
+                if (self.retire.load(std::memory_order_relaxed)) {
+                    break;
+                }
 
-                if (m_stop.load()) {
-                    throw std::runtime_error("Enqueue on stopped ThreadPool");
+                // Sliced jobs take turns with the tasks FindTask hands out
+                self.slice_turn = !self.slice_turn;
+                if (self.slice_turn && TryRunSlice(self)) {
+                    idle_rounds = 0;
+                    continue;
                 }
 
-                usize queue_index = SelectQueue();
+                if (Task* task = FindTask(index)) {
+                    idle_rounds = 0;
+                    RunWorkerTask(self, task);
+                    continue;
+                }
 
-                m_task_queues[queue_index].emplace_back(priority, [task, thread_id_promise]() {
-                    try {
-                        (*task)();
-                        thread_id_promise->set_value(std::this_thread::get_id());
+                if (TryRunSlice(self)) {
+                    idle_rounds = 0;
+                    continue;
+                }
+
+                if (m_stop.load() && m_active_tasks.load() == 0) {
+                    break;
+                }
+
+                if (++idle_rounds < SPIN_ROUNDS) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                // Park: record the epoch, look once more, then sleep until it changes
+                const u32 epoch = m_wake_epoch.load(std::memory_order_seq_cst);
+                m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+                Task* task = FindTask(index);
+                if (!task && !SliceRunnable() && !self.retire.load() && !(m_stop.load() && m_active_tasks.load() == 0)) {
+                    if (m_telemetry.load(std::memory_order_relaxed)) {
+                        const auto parked_at = std::chrono::steady_clock::now();
+                        m_wake_epoch.wait(epoch, std::memory_order_seq_cst);
+                        WorkerCounters::Add(self.counters.parked_ns, ElapsedNs(parked_at));
                     }
-                    catch (...) {
-                        try {
-                            thread_id_promise->set_value(std::this_thread::get_id());
-                        }
-                        catch (...) {
-                        }
+                    else {
+                        m_wake_epoch.wait(epoch, std::memory_order_seq_cst);
                     }
-                    });
+                }
+                m_sleepers.fetch_sub(1, std::memory_order_seq_cst);
+                idle_rounds = 0;
+                if (task) {
+                    RunWorkerTask(self, task);
+                }
+            }
 
-                m_active_tasks.fetch_add(1, std::memory_order_relaxed);
+            // Hand anything still queued here to the rest of the pool
+            Task* task = nullptr;
+            bool moved = false;
+            for (auto& deque : self.deques) {
+                while (deque.Pop(task)) {
+                    std::lock_guard<std::mutex> lock(m_inject_mutex);
+                    Inject(task);
+                    moved = true;
+                }
             }
+            self.mask.store(0, std::memory_order_relaxed);
+            if (moved) {
+                WakeWorkers(true);
+            }
+            t_pool = nullptr;
+        }
 
-            m_condition.notify_one();
-            return task_result;
+        void Initialize(usize num_threads) {
+            AddThreads(num_threads);
         }
 
-        // Add more worker threads to the pool
-        void AddThreads(usize count) {
-            usize current_size = m_workers.size();
-            m_task_queues.resize(current_size + count);
-            m_thread_control.resize(current_size + count);
+        struct TimerEntry {
+            Task* once = nullptr;                          // One-shot: pushed as is
+            std::shared_ptr<std::function<void()>> repeat; // Periodic: a task per run
+            u64 period = 0;                                // In ticks
+            TaskPriority priority = TaskPriority::NORMAL;
+        };
+
+        static constexpr u64 NO_TICK = std::numeric_limits<u64>::max();
+        static constexpr i64 TIMER_TICK_NS = std::chrono::nanoseconds(TIMER_TICK).count();
+
+        template <class Rep, class Period>
+        static u64 TicksCeil(std::chrono::duration<Rep, Period> d) {
+            const i64 ns = std::chrono::ceil<std::chrono::nanoseconds>(d).count();
+            return ns <= 0 ? 0 : static_cast<u64>((ns + TIMER_TICK_NS - 1) / TIMER_TICK_NS);
+        }
+
+        i64 NsSinceTimerEpoch() const {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_timer_epoch).count();
+        }
+
+        // First tick that starts at or after now + delay
+        template <class Rep, class Period>
+        u64 DeadlineAfter(std::chrono::duration<Rep, Period> delay) const {
+            const i64 ns = NsSinceTimerEpoch() + std::max<i64>(0, std::chrono::ceil<std::chrono::nanoseconds>(delay).count());
+            return static_cast<u64>((ns + TIMER_TICK_NS - 1) / TIMER_TICK_NS);
+        }
+
+        TimerId AddTimer(u64 deadline, TimerEntry entry) {
+            std::lock_guard<std::mutex> lock(m_timer_mutex);
+            if (m_timer_stop) {
+                if (entry.once) {
+                    Task::Discard(entry.once);
+                }
+                throw std::runtime_error("Timer added to stopped ThreadPool");
+            }
+            if (!m_timer_thread.joinable()) {
+                m_timer_thread = std::thread(&ThreadPool::TimerThread, this);
+            }
+            const TimerId id = m_timers.Add(deadline, std::move(entry));
+            if (deadline < m_timer_wake_tick) {
+                m_timer_cv.notify_one();
+            }
+            return id;
+        }
+
+        // Caller holds m_timer_mutex (we're inside TimerWheel::Advance)
+        u64 FireTimer(TimerEntry& entry, u64 deadline) {
+            if (entry.once) {
+                Push(std::exchange(entry.once, nullptr));
+                return 0;
+            }
+            Push(Task::Create(entry.priority, [fn = entry.repeat]() { (*fn)(); }));
+            const u64 firing_tick = m_timers.CurrentTick() - 1;
+            const u64 next = deadline + entry.period;
+            return next > firing_tick ? next : firing_tick + entry.period;
+        }
+
+        void TimerThread() {
+            SetCurrentThreadName(m_thread_name + "-timer");
+            std::unique_lock<std::mutex> lock(m_timer_mutex);
+            while (!m_timer_stop) {
+                const u64 now = static_cast<u64>(NsSinceTimerEpoch() / TIMER_TICK_NS);
+                m_timers.Advance(now, [this](TimerEntry& entry, u64 deadline) { return FireTimer(entry, deadline); });
+
+                const std::optional<u64> next = m_timers.NextTick();
+                m_timer_wake_tick = next ? *next : NO_TICK;
+                if (next) {
+                    m_timer_cv.wait_until(lock, m_timer_epoch + std::chrono::nanoseconds(*next * TIMER_TICK_NS));
+                }
+                else {
+                    m_timer_cv.wait(lock);
+                }
+            }
+        }
+
+        // Pending timers are dropped
+        void StopTimers() {
+            {
+                std::lock_guard<std::mutex> lock(m_timer_mutex);
+                m_timer_stop = true;
+            }
+            m_timer_cv.notify_all();
+            if (m_timer_thread.joinable()) {
+                m_timer_thread.join();
+            }
+            std::lock_guard<std::mutex> lock(m_timer_mutex);
+            m_timers.Clear([](TimerEntry& entry) {
+                if (entry.once) {
+                    Task::Discard(entry.once);
+                }
+                });
+        }
+
+        // Caller holds m_resize_mutex. Each thread is counted as soon as it starts, so a
+        // failed spawn leaves the pool consistent at the size reached so far.
+        void GrowLocked(usize count) {
+            const usize current_size = m_worker_count.load(std::memory_order_relaxed);
+            if (current_size + count > MAX_WORKERS) {
+                throw std::runtime_error("ThreadPool worker limit exceeded");
+            }
 
             for (usize i = current_size; i < current_size + count; ++i) {
-                m_thread_control[i] = std::make_shared<ThreadControlBlock>();
-                m_workers.emplace_back(&ThreadPool::WorkerThread, this, i);
+                if (!m_workers[i]) {
+                    m_workers[i] = std::make_unique<Worker>();
+                }
+                m_workers[i]->retire.store(false, std::memory_order_relaxed);
+                m_workers[i]->thread = std::thread(&ThreadPool::WorkerThread, this, i);
+                m_worker_count.store(i + 1, std::memory_order_release);
             }
         }
 
-        // Remove worker threads from the pool
-        void RemoveThreads(usize count) {
-            for (usize i = 0; i < count && !m_workers.empty(); ++i) {
-                {
-                    std::lock_guard<std::mutex> lock(m_queue_mutex);
-                    m_stop.store(true);
+        // Caller holds m_resize_mutex
+        void ShrinkLocked(usize count) {
+            if (IsWorkerThread()) {
+                throw std::logic_error("ThreadPool::RemoveThreads called from a worker thread");
+            }
+            for (usize i = 0; i < count && m_worker_count.load(std::memory_order_relaxed) > 0; ++i) {
+                const usize index = m_worker_count.load(std::memory_order_relaxed) - 1;
+                Worker& worker = *m_workers[index];
+                worker.retire.store(true);
+                WakeWorkers(true);
+
+                if (worker.thread.joinable()) {
+                    worker.thread.join();
+                }
+                m_worker_count.store(index, std::memory_order_release);
+            }
+        }
+
+        // One auto-scaler step, taken from the size as it is under the resize lock so a
+        // concurrent SetThreadCount isn't undone or pushed outside the policy bounds
+        void ScaleStep(bool grow) {
+            std::lock_guard<std::mutex> lock(m_resize_mutex);
+            const usize current = m_worker_count.load(std::memory_order_relaxed);
+            if (grow && current < m_scale_policy.max_threads) {
+                GrowLocked(1);
+            }
+            else if (!grow && current > m_scale_policy.min_threads) {
+                ShrinkLocked(1);
+            }
+        }
+
+        void AutoScaleThread() {
+            SetCurrentThreadName(m_thread_name + "-scale");
+            std::chrono::milliseconds idle_for{ 0 };
+            std::unique_lock<std::mutex> lock(m_scale_mutex);
+            while (!m_scale_cv.wait_for(lock, m_scale_policy.sample_interval, [this]() { return m_scale_stop; })) {
+                const usize count = GetThreadCount();
+                // Active tasks beyond one per worker are (roughly) the ones still queued
+                const usize active = static_cast<usize>(m_active_tasks.load(std::memory_order_relaxed));
+                const usize queued = active > count ? active - count : 0;
+
+                if (count < m_scale_policy.max_threads && queued > m_scale_policy.grow_queue_depth * std::max<usize>(count, 1)) {
+                    // A failed spawn (out of threads or memory) just skips this step; letting it
+                    // escape would terminate the process
+                    try {
+                        ScaleStep(true);
+                    }
+                    catch (const std::exception&) {
+                    }
+                    idle_for = std::chrono::milliseconds(0);
+                    continue;
                 }
-                m_condition.notify_all();
 
-                if (m_workers.back().joinable()) {
-                    m_workers.back().join();
+                if (queued == 0 && m_sleepers.load(std::memory_order_relaxed) > 0) {
+                    idle_for += m_scale_policy.sample_interval;
+                }
+                else {
+                    idle_for = std::chrono::milliseconds(0);
                 }
-                m_workers.pop_back();
-                m_task_queues.pop_back();
-                m_thread_control.pop_back();
+                if (idle_for >= m_scale_policy.shrink_idle_time && count > m_scale_policy.min_threads) {
+                    // The retiring worker may be mid-task; don't hold up DisableAutoScale meanwhile
+                    lock.unlock();
+                    ScaleStep(false);
+                    lock.lock();
+                    idle_for = std::chrono::milliseconds(0);
+                }
+            }
+        }
+
+        // Data Members
+        std::array<std::unique_ptr<Worker>, MAX_WORKERS> m_workers;  // Worker slots, [0, m_worker_count) running
+        std::atomic<usize> m_worker_count{ 0 };
+        std::mutex m_resize_mutex;           // Serializes every resize and Shutdown
+
+        // Tasks submitted from outside the pool, one FIFO per priority
+        std::mutex m_inject_mutex;
+        std::array<std::deque<Task*>, PRIORITY_COUNT> m_injected;
+        std::atomic<u32> m_injected_mask{ 0 }; // Non-empty levels; written under m_inject_mutex
+
+        alignas(CACHE_LINE_SIZE) std::atomic<u32> m_wake_epoch{ 0 }; // Parking word
+        alignas(CACHE_LINE_SIZE) std::atomic<u32> m_sleepers{ 0 };
+        // Threads inside WaitUntil sleep on their own word, so completions don't wake parked workers
+        alignas(CACHE_LINE_SIZE) std::atomic<u32> m_waiter_epoch{ 0 };
+        std::atomic<u32> m_waiters{ 0 };
+
+        // Placement; m_worker_cpus is empty when workers are left to the OS
+        std::string m_thread_name;
+        bool m_pin_workers;
+        std::vector<CpuInfo> m_worker_cpus; // Slot i runs on m_worker_cpus[i % size] when pinned
+
+        // Delayed and periodic tasks; the wheel ticks at TIMER_TICK from m_timer_epoch
+        std::thread m_timer_thread;
+        std::mutex m_timer_mutex;
+        std::condition_variable m_timer_cv;
+        TimerWheel<TimerEntry> m_timers;
+        std::chrono::steady_clock::time_point m_timer_epoch = std::chrono::steady_clock::now();
+        u64 m_timer_wake_tick = NO_TICK;  // When the timer thread next wakes by itself
+        bool m_timer_stop = false;
+
+        // Sliced background jobs, round robin; m_sliced_pending mirrors the size for lock-free checks
+        std::mutex m_sliced_mutex;
+        std::deque<std::shared_ptr<detail::SlicedJobState>> m_sliced_jobs;
+        std::atomic<usize> m_sliced_pending{ 0 };
+        std::atomic<i64> m_slice_budget{ 0 };                  // Per frame, in ns
+        std::atomic<i64> m_slice_remaining{ UNBUDGETED };      // Left this frame
+        // Tasks queued at FRAME_LEVELS and not yet taken, pool-wide. The per-worker masks
+        // can't answer this: only their owner clears a bit, so one left set after thieves
+        // emptied the deque would hold sliced jobs back indefinitely.
+        alignas(CACHE_LINE_SIZE) std::atomic<i64> m_frame_queued{ 0 };
+
+        // Auto-scaling monitor; m_scale_policy is written only while it isn't running
+        std::thread m_scale_thread;
+        std::mutex m_scale_mutex;
+        std::condition_variable m_scale_cv;
+        bool m_scale_stop = false;
+        AutoScalePolicy m_scale_policy;
+
+        std::atomic<bool> m_telemetry{ false };
+        std::atomic<bool> m_stop;            // Flag to indicate pool shutdown
+        alignas(CACHE_LINE_SIZE) std::atomic<unsigned long> m_active_tasks; // Number of active tasks
+    };
 
-                m_stop.store(false);
+    // Work handed to one particular thread, normally the main thread: anyone may Post,
+    // and the owner runs what was posted when it calls Drain(), e.g. once per frame.
+    // Entries are pooled Task blocks, so posting a small lambda doesn't allocate.
+    class MainThreadQueue {
+    public:
+        MainThreadQueue() = default;
+        MainThreadQueue(const MainThreadQueue&) = delete;
+        MainThreadQueue& operator=(const MainThreadQueue&) = delete;
+
+        // Undrained entries are dropped; a coroutine waiting in Schedule() is never resumed
+        ~MainThreadQueue() {
+            for (usize i = m_next; i < m_draining.size(); ++i) {
+                Task::Discard(m_draining[i]);
+            }
+            for (Task* task : m_pending) {
+                Task::Discard(task);
             }
         }
 
-        // Wait for all tasks to complete
-        void WaitForAllTasks() {
-            while (m_active_tasks.load(std::memory_order_relaxed) != 0) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        template <class F>
+        void Post(F&& f) {
+            Task* task = Task::Create(TaskPriority::NORMAL, std::forward<F>(f));
+            ThreadPool* waiting_pool;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_pending.push_back(task);
+                m_size.store(m_pending.size(), std::memory_order_relaxed);
+                waiting_pool = m_waiting_pool;
+            }
+            if (waiting_pool) {
+                waiting_pool->NotifyWaiters();
             }
         }
 
-        // DANGEROUS CALL
-        void Shutdown() {
-            m_stop.store(true);
-            m_condition.notify_all();
+        struct ScheduleAwaiter {
+            MainThreadQueue& queue;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                queue.Post([handle]() { handle.resume(); });
+            }
+            void await_resume() const noexcept {}
+        };
+
+        // `co_await queue.Schedule()` resumes the coroutine inside the owner's Drain()
+        ScheduleAwaiter Schedule() {
+            return { *this };
+        }
+
+        // Owner thread only, not reentrant. Runs everything posted before the call, in
+        // order; what those entries post waits for the next Drain. Exceptions are
+        // dropped, as with Submit.
+        usize Drain() {
+            return Drain(std::chrono::nanoseconds::max());
+        }
+
+        // As Drain(), but stops starting entries once `budget` has passed (it always
+        // runs at least one). The rest stay first in line for the next Drain.
+        usize Drain(std::chrono::nanoseconds budget) {
+            if (m_size.load(std::memory_order_relaxed) != 0) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_next == m_draining.size()) {
+                    m_draining.clear();
+                    m_next = 0;
+                    m_draining.swap(m_pending);
+                }
+                else {
+                    m_draining.insert(m_draining.end(), m_pending.begin(), m_pending.end());
+                    m_pending.clear();
+                }
+                m_size.store(0, std::memory_order_relaxed);
+            }
 
-            for (std::thread& worker : m_workers) {
-                if (worker.joinable()) {
-                    worker.join();
+            const bool budgeted = budget != std::chrono::nanoseconds::max();
+            const auto deadline = budgeted ? std::chrono::steady_clock::now() + budget : std::chrono::steady_clock::time_point::max();
+            usize count = 0;
+            while (m_next < m_draining.size()) {
+                Task::Execute(m_draining[m_next++]);
+                ++count;
+                if (budgeted && std::chrono::steady_clock::now() >= deadline) {
+                    break;
                 }
             }
+            if (m_next == m_draining.size()) {
+                m_draining.clear();
+                m_next = 0;
+            }
+            m_carried.store(m_draining.size() - m_next, std::memory_order_relaxed);
+            return count;
+        }
+
+        bool Empty() const {
+            return m_size.load(std::memory_order_relaxed) == 0 && m_carried.load(std::memory_order_relaxed) == 0;
+        }
+
+        // Owner thread only, not from inside a drained entry. As pool.WaitUntil(done,
+        // lowest), but also drains this queue whenever something is posted, so work
+        // that hops onto the owner thread can still finish what is being waited for.
+        template <typename Pred>
+        void WaitUntil(ThreadPool& pool, Pred&& done, TaskPriority lowest = TaskPriority::BACKGROUND) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_waiting_pool = &pool;
+            }
+            while (!done()) {
+                pool.WaitUntil([this, &done]() { return done() || !Empty(); }, lowest);
+                Drain();
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_waiting_pool = nullptr;
         }
 
     private:
-        // Worker thread function
-        void WorkerThread(usize index) {
-            // Assign thread ID to control block
-            m_thread_control[index]->thread_id = std::this_thread::get_id();
+        std::mutex m_mutex;
+        std::vector<Task*> m_pending;
+        std::vector<Task*> m_draining; // Owner only; [m_next, end) carried over from a budgeted Drain
+        usize m_next = 0;
+        std::atomic<usize> m_size{ 0 };
+        std::atomic<usize> m_carried{ 0 };
+        ThreadPool* m_waiting_pool = nullptr; // Guarded by m_mutex; set while the owner is in WaitUntil
+    };
 
-            while (true) {
-                std::pair<TaskPriority, std::function<void()>> task;
-
-                {
-                    std::unique_lock<std::mutex> lock(m_queue_mutex);
-                    m_condition.wait(lock, [this, index]() {
-                        return m_stop.load() ||
-                            !m_task_queues[index].empty() ||
-                            std::any_of(m_task_queues.begin(), m_task_queues.end(), [](const auto& q) { return !q.empty(); });
-                        });
-
-
-                    if (m_stop.load() && m_active_tasks.load() == 0) {
-                        return;
-                    }
-
-                    if (!m_task_queues[index].empty()) {
-                        // Find the highest priority task
-                        auto it = std::max_element(
-                            m_task_queues[index].begin(),
-                            m_task_queues[index].end(),
-                            [](const std::pair<TaskPriority, std::function<void()>>& a,
-                                const std::pair<TaskPriority, std::function<void()>>& b) -> bool {
-                                    return a.first < b.first;
-                            });
-
-                        if (it != m_task_queues[index].end()) {
-                            task = *it;
-                            m_task_queues[index].erase(it);
+    template <typename R>
+    void TaskHandle<R>::Wait() const {
+        m_state->pool->WaitUntil([this]() { return IsReady(); }, m_state->priority);
+    }
+
+    // Joins a batch of tasks without a handle per task. Wait() runs queued pool work
+    // on the waiting thread until every task in the group has finished, so a thread
+    // blocked on its own jobs helps finish them instead of sleeping. A thread outside
+    // the pool only helps with work at least as urgent as the group's least urgent task.
+    //
+    //     TaskGroup group(pool);
+    //     for (auto& chunk : chunks) {
+    //         group.Run(TaskPriority::HIGH, [&chunk] { Process(chunk); });
+    //     }
+    //     group.Wait();
+    class TaskGroup {
+    public:
+        explicit TaskGroup(ThreadPool& pool)
+            : m_pool(pool) {
+        }
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        // Tasks capture the group, so it can't go away under them
+        ~TaskGroup() {
+            m_pool.WaitUntil([this]() { return IsDone(); }, Lowest());
+        }
+
+        template <class F>
+        void Run(TaskPriority priority, F&& f) {
+            u32 lowest = m_lowest.load(std::memory_order_relaxed);
+            while (lowest < static_cast<u32>(priority) &&
+                !m_lowest.compare_exchange_weak(lowest, static_cast<u32>(priority), std::memory_order_relaxed)) {
+            }
+            m_pending.fetch_add(1, std::memory_order_relaxed);
+            try {
+                // The pool is captured on its own: once the count hits zero the group may be gone
+                m_pool.Submit(priority, [this, pool = &m_pool, fn = std::forward<F>(f)]() mutable {
+                    try {
+                        fn();
+                    }
+                    catch (...) {
+                        if (!m_has_error.exchange(true, std::memory_order_acq_rel)) {
+                            m_error = std::current_exception();
                         }
                     }
+                    if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        pool->NotifyWaiters();
+                    }
+                    });
+            }
+            catch (...) {
+                m_pending.fetch_sub(1, std::memory_order_relaxed);
+                throw;
+            }
+        }
 
-                    // If no task found, attempt to steal
-                    if (task.second == nullptr) {
-                        if (StealTask(index, task)) {
-                            // Successfully stole a task
-                        }
+        bool IsDone() const {
+            return m_pending.load(std::memory_order_acquire) == 0;
+        }
+
+        // Helps until the group is empty, then rethrows the first exception a task threw.
+        // The group can be reused afterwards.
+        void Wait() {
+            m_pool.WaitUntil([this]() { return IsDone(); }, Lowest());
+            m_lowest.store(0, std::memory_order_relaxed);
+            if (m_has_error.load(std::memory_order_acquire)) {
+                m_has_error.store(false, std::memory_order_relaxed);
+                std::rethrow_exception(std::exchange(m_error, nullptr));
+            }
+        }
+
+    private:
+        TaskPriority Lowest() const {
+            return static_cast<TaskPriority>(m_lowest.load(std::memory_order_relaxed));
+        }
+
+        ThreadPool& m_pool;
+        alignas(CACHE_LINE_SIZE) std::atomic<u32> m_pending{ 0 };
+        std::atomic<u32> m_lowest{ 0 }; // Least urgent priority run since the last Wait
+        std::atomic<bool> m_has_error{ false };
+        std::exception_ptr m_error;
+    };
+
+    // Per-frame DAG of tasks. Build it once (AddTask/Precede), then Run() it every
+    // frame: each node keeps its predecessor count and successor list, so a run only
+    // resets counters and submits the roots, with no allocation. A node is scheduled
+    // the moment its last predecessor finishes; the first successor it releases runs
+    // straight away on the same worker, the rest go to that worker's deque.
+    //
+    //     TaskGraph frame;
+    //     auto physics   = frame.AddTask([&] { StepPhysics(); });
+    //     auto animation = frame.AddTask([&] { Animate(); });
+    //     auto culling   = frame.AddTask([&] { Cull(); });
+    //     auto commands  = frame.AddTask([&] { BuildCommands(); });
+    //     frame.Precede(physics, animation);
+    //     frame.Precede(animation, culling);
+    //     frame.Precede(culling, commands);
+    //     ...
+    //     frame.Run(pool); frame.Wait();
+    class TaskGraph {
+    public:
+        using NodeId = u32;
+
+        TaskGraph() = default;
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        ~TaskGraph() {
+            if (m_running) {
+                Wait();
+            }
+        }
+
+        NodeId AddTask(std::function<void()> fn, TaskPriority priority = TaskPriority::NORMAL) {
+            assert(!m_running);
+            m_nodes.push_back({ std::move(fn), priority, 0, {} });
+            m_validated = false;
+            return static_cast<NodeId>(m_nodes.size() - 1);
+        }
+
+        // `after` runs only once `before` has finished
+        TaskGraph& Precede(NodeId before, NodeId after) {
+            assert(!m_running && before < m_nodes.size() && after < m_nodes.size());
+            m_nodes[before].successors.push_back(after);
+            ++m_nodes[after].predecessor_count;
+            m_validated = false;
+            return *this;
+        }
+
+        // Makes `node` depend on every node in `predecessors`
+        TaskGraph& DependsOn(NodeId node, std::initializer_list<NodeId> predecessors) {
+            for (NodeId before : predecessors) {
+                Precede(before, node);
+            }
+            return *this;
+        }
+
+        void Clear() {
+            assert(!m_running);
+            m_nodes.clear();
+            m_roots.clear();
+            m_validated = false;
+        }
+
+        usize Size() const {
+            return m_nodes.size();
+        }
+
+        // Starts the graph on `pool` and returns immediately. Throws if the graph has
+        // a cycle (checked once after each edit).
+        void Run(ThreadPool& pool) {
+            assert(!m_running);
+            if (!m_validated) {
+                Prepare();
+            }
+            if (m_nodes.empty()) {
+                return;
+            }
+
+            for (usize i = 0; i < m_nodes.size(); ++i) {
+                m_pending[i].store(m_nodes[i].predecessor_count, std::memory_order_relaxed);
+            }
+            m_error = nullptr;
+            m_has_error.store(false, std::memory_order_relaxed);
+            m_remaining.store(static_cast<u32>(m_nodes.size()), std::memory_order_relaxed);
+            m_finished.store(false, std::memory_order_relaxed);
+            m_running = true;
+            m_pool = &pool;
+
+            for (NodeId root : m_roots) {
+                Schedule(root);
+            }
+        }
+
+        bool IsDone() const {
+            return m_remaining.load(std::memory_order_acquire) == 0;
+        }
+
+        // Blocks until every node has run, running pool tasks no less urgent than the
+        // least urgent node meanwhile, then rethrows the first exception a node threw
+        void Wait() {
+            if (m_running) {
+                m_pool->WaitUntil([this]() { return IsDone(); }, m_lowest);
+            }
+            // The last node may still be inside NotifyWaiters; don't let the graph go away under it
+            while (m_running && !m_finished.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            m_running = false;
+            if (m_has_error.load(std::memory_order_acquire)) {
+                std::rethrow_exception(std::exchange(m_error, nullptr));
+            }
+        }
+
+    private:
+        struct Node {
+            std::function<void()> fn;
+            TaskPriority priority;
+            u32 predecessor_count;
+            std::vector<NodeId> successors;
+        };
+
+        // Finds the roots and rejects cycles (Kahn's algorithm)
+        void Prepare() {
+            m_roots.clear();
+            m_lowest = TaskPriority::CRITICAL;
+            std::vector<u32> indegree(m_nodes.size());
+            std::vector<NodeId> ready;
+            for (usize i = 0; i < m_nodes.size(); ++i) {
+                m_lowest = std::max(m_lowest, m_nodes[i].priority);
+                indegree[i] = m_nodes[i].predecessor_count;
+                if (indegree[i] == 0) {
+                    m_roots.push_back(static_cast<NodeId>(i));
+                    ready.push_back(static_cast<NodeId>(i));
+                }
+            }
+            usize visited = 0;
+            while (!ready.empty()) {
+                NodeId n = ready.back();
+                ready.pop_back();
+                ++visited;
+                for (NodeId s : m_nodes[n].successors) {
+                    if (--indegree[s] == 0) {
+                        ready.push_back(s);
+                    }
+                }
+            }
+            if (visited != m_nodes.size()) {
+                throw std::runtime_error("TaskGraph contains a cycle");
+            }
+
+            if (m_pending_capacity < m_nodes.size()) {
+                m_pending = std::make_unique<std::atomic<u32>[]>(m_nodes.size());
+                m_pending_capacity = m_nodes.size();
+            }
+            m_validated = true;
+        }
+
+        void Schedule(NodeId node) {
+            m_pool->Submit(m_nodes[node].priority, [this, node]() { Execute(node); });
+        }
+
+        void Execute(NodeId node) {
+            while (true) {
+                try {
+                    m_nodes[node].fn();
+                }
+                catch (...) {
+                    if (!m_has_error.exchange(true, std::memory_order_acq_rel)) {
+                        m_error = std::current_exception();
                     }
+                }
 
-                    if (task.second == nullptr) {
-                        // No task found, continue waiting
-                        continue;
+                // Keep the first released successor as a continuation on this thread
+                NodeId next = INVALID_NODE;
+                for (NodeId s : m_nodes[node].successors) {
+                    if (m_pending[s].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        if (next == INVALID_NODE) {
+                            next = s;
+                        }
+                        else {
+                            Schedule(s);
+                        }
                     }
                 }
 
-                // Execute the task outside the lock
-                if (task.second) {
-                    task.second();
-                    m_active_tasks.fetch_sub(1, std::memory_order_relaxed);
+                if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    m_pool->NotifyWaiters();
+                    m_finished.store(true, std::memory_order_release);
+                    return;
                 }
+                if (next == INVALID_NODE) {
+                    return;
+                }
+                node = next;
             }
         }
 
-        // Steal a task from other queues
-        bool StealTask(usize thief_index, std::pair<TaskPriority, std::function<void()>>& task) {
-            for (usize i = 0; i < m_task_queues.size(); ++i) {
-                if (i == thief_index) continue;
+        static constexpr NodeId INVALID_NODE = std::numeric_limits<NodeId>::max();
+
+        std::vector<Node> m_nodes;
+        std::vector<NodeId> m_roots;
+        std::unique_ptr<std::atomic<u32>[]> m_pending; // Per node, reset by Run
+        usize m_pending_capacity = 0;
+        TaskPriority m_lowest = TaskPriority::CRITICAL; // Least urgent node; bounds what Wait helps with
+        bool m_validated = false;
+        bool m_running = false;
+        ThreadPool* m_pool = nullptr;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<u32> m_remaining{ 0 };
+        std::atomic<bool> m_finished{ false };
+        std::atomic<bool> m_has_error{ false };
+        std::exception_ptr m_error;
+    };
+
 
-                if (!m_task_queues[i].empty()) {
-                    // Steal the lowest priority task
-                    auto it = std::min_element(
-                        m_task_queues[i].begin(),
-                        m_task_queues[i].end(),
-                        [](const std::pair<TaskPriority, std::function<void()>>& a,
-                            const std::pair<TaskPriority, std::function<void()>>& b) -> bool {
-                                return a.first < b.first;
-                        });
+    namespace detail {
+
+        // Shared state of one ParallelFor-style call. Lives in a pooled task block and is
+        // reference counted, so a helper task that only starts after the caller returned
+        // still finds valid memory; it just sees nothing left to claim.
+        struct ParallelState {
+            std::atomic<usize> next;         // First unclaimed index
+            std::atomic<usize> remaining;    // Indices claimed but not finished, plus unclaimed
+            std::atomic<u32> refs;
+            std::atomic<u32> next_participant{ 1 }; // 0 is the caller
+            std::atomic<bool> failed{ false };
+            usize end;
+            usize grain;
+            usize participants;
+            std::exception_ptr error;
+            ThreadPool* pool;
+            const void* body;
+            void (*invoke)(const void* body, usize participant, usize begin, usize end);
+
+            void Release() {
+                if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    this->~ParallelState();
+                    TaskBlockPool::Free(this);
+                }
+            }
 
-                    if (it != m_task_queues[i].end()) {
-                        task = *it;
-                        m_task_queues[i].erase(it);
+            // Guided self-scheduling: claim a share of what's left, never below the grain,
+            // so early chunks are big and the tail is split finely for balance
+            bool Claim(usize& b, usize& e) {
+                usize cur = next.load(std::memory_order_relaxed);
+                while (cur < end) {
+                    const usize left = end - cur;
+                    const usize size = std::min(left, std::max(grain, left / (2 * participants)));
+                    if (next.compare_exchange_weak(cur, cur + size, std::memory_order_relaxed)) {
+                        b = cur;
+                        e = cur + size;
                         return true;
                     }
                 }
+                return false;
             }
-            return false;
-        }
-
-        // Select a queue index for the current task
-        usize SelectQueue() {
-            std::lock_guard<std::mutex> lock(m_rng_mutex);
-            std::uniform_int_distribution<usize> dist(0, m_task_queues.size() - 1);
-            return dist(m_rng);
-        }
 
-        void Initialize(usize num_threads) {
-            m_task_queues.resize(num_threads);
-            m_thread_control.resize(num_threads);
+            void Work(usize participant) {
+                usize b, e;
+                // After a failure the rest is still claimed (and skipped) so the count drains
+                while (Claim(b, e)) {
+                    if (!failed.load(std::memory_order_relaxed)) {
+                        try {
+                            invoke(body, participant, b, e);
+                        }
+                        catch (...) {
+                            if (!failed.exchange(true, std::memory_order_acq_rel)) {
+                                error = std::current_exception();
+                            }
+                        }
+                    }
+                    if (remaining.fetch_sub(e - b, std::memory_order_acq_rel) == e - b) {
+                        pool->NotifyWaiters();
+                    }
+                }
+            }
+        };
+
+        static_assert(FITS_TASK_BLOCK<ParallelState>);
+
+        // Runs body(participant, begin, end) over [begin, end) on up to
+        // GetThreadCount() helpers plus the calling thread, which takes part until
+        // every index is claimed and then helps with other pool work until the chunks
+        // still in flight are done.
+        // Returns the number of participants, i.e. the valid range of `participant`.
+        template <typename Body>
+        usize ParallelRun(ThreadPool& pool, usize begin, usize end, usize grain, usize max_participants, const Body& body) {
+            if (begin >= end) {
+                return 1;
+            }
+            const usize count = end - begin;
+            const usize workers = pool.GetThreadCount();
+            usize participants = std::min(max_participants, workers + 1);
+            if (grain == 0) {
+                grain = std::max<usize>(1, count / (8 * participants));
+            }
+            participants = std::min(participants, (count + grain - 1) / grain);
+            if (participants <= 1) {
+                body(usize(0), begin, end);
+                return 1;
+            }
 
-            for (usize i = 0; i < num_threads; ++i) {
-                m_thread_control[i] = std::make_shared<ThreadControlBlock>();
-                m_workers.emplace_back(&ThreadPool::WorkerThread, this, i);
+            ParallelState* state = new (TaskBlockPool::Allocate()) ParallelState();
+            state->next.store(begin, std::memory_order_relaxed);
+            state->remaining.store(count, std::memory_order_relaxed);
+            state->refs.store(static_cast<u32>(participants), std::memory_order_relaxed);
+            state->end = end;
+            state->grain = grain;
+            state->participants = participants;
+            state->pool = &pool;
+            state->body = &body;
+            state->invoke = [](const void* b, usize participant, usize lo, usize hi) {
+                (*static_cast<const Body*>(b))(participant, lo, hi);
+                };
+
+            for (usize i = 1; i < participants; ++i) {
+                pool.Submit(TaskPriority::HIGH, [state]() {
+                    state->Work(state->next_participant.fetch_add(1, std::memory_order_relaxed));
+                    state->Release();
+                    });
             }
-        }
 
-        // Data Members
-        std::vector<std::thread> m_workers;  // Vector of worker threads
-        std::vector<std::shared_ptr<ThreadControlBlock>> m_thread_control; // Control blocks for workers
-        std::vector<std::deque<std::pair<TaskPriority, std::function<void()>>>> m_task_queues; // Per-thread task queues
+            state->Work(0);
+            pool.WaitUntil([state]() { return state->remaining.load(std::memory_order_acquire) == 0; }, TaskPriority::HIGH);
 
-        std::mutex m_queue_mutex;            // Mutex for task queues
-        std::condition_variable m_condition; // Condition variable for task availability
+            std::exception_ptr error = state->failed.load(std::memory_order_acquire) ? state->error : nullptr;
+            state->Release();
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return participants;
+        }
+    }
+
+    // Calls fn over [begin, end) in parallel, with the calling thread taking part.
+    // fn is either fn(usize index) or fn(usize chunk_begin, usize chunk_end); the
+    // range form lets the body keep per-chunk state. grain is the smallest chunk
+    // handed out (0 picks one from the range size and the pool's thread count).
+    template <typename Fn>
+    void ParallelFor(ThreadPool& pool, usize begin, usize end, usize grain, Fn&& fn) {
+        detail::ParallelRun(pool, begin, end, grain, ThreadPool::MAX_WORKERS + 1, [&fn](usize, usize b, usize e) {
+            if constexpr (std::is_invocable_v<Fn&, usize, usize>) {
+                fn(b, e);
+            }
+            else {
+                for (usize i = b; i < e; ++i) {
+                    fn(i);
+                }
+            }
+            });
+    }
+
+    // Folds [begin, end) into one value: map(chunk_begin, chunk_end) -> T for each chunk,
+    // combined with reduce(T, T) -> T starting from identity. reduce must be
+    // associative; the grouping depends on scheduling, so floating point sums can vary
+    // in the last bits between runs.
+    template <typename T, typename MapFn, typename ReduceFn>
+    T ParallelReduce(ThreadPool& pool, usize begin, usize end, usize grain, T identity, MapFn&& map, ReduceFn&& reduce) {
+        // One accumulator per participant, each on its own cache line
+        struct alignas(CACHE_LINE_SIZE) Slot {
+            T value;
+        };
+        const usize max_participants = pool.GetThreadCount() + 1;
+        std::vector<Slot> slots(max_participants, Slot{ identity });
+
+        const usize participants = detail::ParallelRun(pool, begin, end, grain, max_participants,
+            [&](usize participant, usize b, usize e) {
+                slots[participant].value = reduce(std::move(slots[participant].value), map(b, e));
+            });
+
+        T result = identity;
+        for (usize i = 0; i < participants; ++i) {
+            result = reduce(std::move(result), std::move(slots[i].value));
+        }
+        return result;
+    }
+
+    // Inclusive scan of [first, last) into out with an associative op (out may equal
+    // first). Two passes over a fixed block split: block totals in parallel, a short
+    // serial scan over the totals, then every block rescanned from its offset.
+    template <typename InputIt, typename OutputIt, typename T, typename Op>
+    void ParallelScan(ThreadPool& pool, InputIt first, InputIt last, OutputIt out, T identity, Op&& op) {
+        const usize count = static_cast<usize>(std::distance(first, last));
+        if (count == 0) {
+            return;
+        }
+        const usize blocks = std::min<usize>(count, (pool.GetThreadCount() + 1) * 4);
+        const usize block_size = (count + blocks - 1) / blocks;
+        std::vector<T> totals(blocks, identity);
+
+        ParallelFor(pool, 0, blocks, 1, [&](usize blk) {
+            const usize b = blk * block_size;
+            const usize e = std::min(count, b + block_size);
+            T acc = identity;
+            for (usize i = b; i < e; ++i) {
+                acc = op(std::move(acc), first[i]);
+            }
+            totals[blk] = std::move(acc);
+            });
+
+        T running = identity;
+        for (usize blk = 0; blk < blocks; ++blk) {
+            T next = op(running, totals[blk]);
+            totals[blk] = std::move(running);
+            running = std::move(next);
+        }
 
-        std::atomic<bool> m_stop;            // Flag to indicate pool shutdown
-        std::atomic<unsigned long> m_active_tasks; // Number of active tasks
+        ParallelFor(pool, 0, blocks, 1, [&](usize blk) {
+            const usize b = blk * block_size;
+            const usize e = std::min(count, b + block_size);
+            T acc = totals[blk];
+            for (usize i = b; i < e; ++i) {
+                acc = op(std::move(acc), first[i]);
+                out[i] = acc;
+            }
+            });
+    }
+
+    // Stable parallel merge sort: blocks are stable-sorted in parallel, then merged
+    // pairwise, each round's merges running in parallel, through one scratch buffer.
+    template <typename RandomIt, typename Compare = std::less<>>
+    void ParallelSort(ThreadPool& pool, RandomIt first, RandomIt last, Compare comp = {}) {
+        using Value = typename std::iterator_traits<RandomIt>::value_type;
+        const usize count = static_cast<usize>(std::distance(first, last));
+        constexpr usize MIN_BLOCK = 2048;
+        const usize blocks = std::min<usize>(std::bit_ceil(pool.GetThreadCount() + 1), std::max<usize>(1, count / MIN_BLOCK));
+        if (blocks <= 1) {
+            std::stable_sort(first, last, comp);
+            return;
+        }
 
-        // Random number generator for queue selection
-        std::mt19937 m_rng;
-        std::mutex m_rng_mutex;              // Mutex for RNG
-    };
+        const usize block_size = (count + blocks - 1) / blocks;
+        ParallelFor(pool, 0, blocks, 1, [&](usize blk) {
+            const usize b = std::min(count, blk * block_size);
+            const usize e = std::min(count, b + block_size);
+            std::stable_sort(first + b, first + e, comp);
+            });
+
+        std::vector<Value> scratch(count);
+        bool in_scratch = false;
+        for (usize width = block_size; width < count; width *= 2) {
+            const usize pairs = (count + 2 * width - 1) / (2 * width);
+            ParallelFor(pool, 0, pairs, 1, [&](usize p) {
+                const usize b = p * 2 * width;
+                const usize m = std::min(count, b + width);
+                const usize e = std::min(count, b + 2 * width);
+                if (in_scratch) {
+                    std::merge(std::make_move_iterator(scratch.begin() + b), std::make_move_iterator(scratch.begin() + m),
+                        std::make_move_iterator(scratch.begin() + m), std::make_move_iterator(scratch.begin() + e),
+                        first + b, comp);
+                }
+                else {
+                    std::merge(std::make_move_iterator(first + b), std::make_move_iterator(first + m),
+                        std::make_move_iterator(first + m), std::make_move_iterator(first + e),
+                        scratch.begin() + b, comp);
+                }
+                });
+            in_scratch = !in_scratch;
+        }
+        if (in_scratch) {
+            ParallelFor(pool, 0, count, MIN_BLOCK, [&](usize b, usize e) {
+                std::move(scratch.begin() + b, scratch.begin() + e, first + b);
+                });
+        }
+    }
 
 
     // LockedRef provides exclusive (write) access.
@@ -0,0 +1,199 @@
+#include "spark_threading.hpp"
+#include <iostream>
+#include <atomic>
+#include <numeric>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Correctness checks for SpscRing, MpscRing and MpmcQueue. Exits non-zero on any failure.
+
+using spark::threading::SpscRing;
+using spark::threading::MpscRing;
+using spark::threading::MpmcQueue;
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond "\n"; \
+            ++g_failures; \
+        } \
+    } while (0)
+
+template <typename Queue>
+void testSingleItem() {
+    Queue queue(5);
+    CHECK(queue.Capacity() == 8);
+
+    uint64_t value = 0;
+    CHECK(!queue.TryPop(value));
+    for (uint64_t i = 0; i < queue.Capacity(); ++i) {
+        CHECK(queue.TryPush(i));
+    }
+    CHECK(!queue.TryPush(uint64_t(99)));
+    CHECK(queue.SizeApprox() == queue.Capacity());
+    for (uint64_t i = 0; i < queue.Capacity(); ++i) {
+        CHECK(queue.TryPop(value) && value == i);
+    }
+    CHECK(!queue.TryPop(value));
+    CHECK(queue.SizeApprox() == 0);
+}
+
+template <typename Queue>
+void testBatch() {
+    Queue queue(8);
+    std::vector<uint64_t> in(12);
+    std::iota(in.begin(), in.end(), 0);
+
+    // Only as many as fit go in, from the front
+    CHECK(queue.TryPushBatch(std::span<uint64_t>(in)) == 8);
+    CHECK(queue.TryPushBatch(std::span<uint64_t>(in.data() + 8, 4)) == 0);
+
+    std::vector<uint64_t> out(5);
+    CHECK(queue.TryPopBatch(std::span<uint64_t>(out)) == 5);
+    for (uint64_t i = 0; i < 5; ++i) {
+        CHECK(out[i] == i);
+    }
+    CHECK(queue.TryPushBatch(std::span<uint64_t>(in.data() + 8, 4)) == 4);
+
+    out.assign(16, 0);
+    CHECK(queue.TryPopBatch(std::span<uint64_t>(out)) == 7);
+    for (uint64_t i = 0; i < 7; ++i) {
+        CHECK(out[i] == i + 5);
+    }
+    CHECK(queue.TryPopBatch(std::span<uint64_t>(out)) == 0);
+}
+
+template <typename Queue>
+void testEmptySpans() {
+    Queue queue(4);
+    std::span<uint64_t> none;
+
+    // Empty queue, then full queue: zero either way, and no spinning
+    CHECK(queue.TryPushBatch(none) == 0);
+    CHECK(queue.TryPopBatch(none) == 0);
+    for (uint64_t i = 0; i < queue.Capacity(); ++i) {
+        CHECK(queue.TryPush(i));
+    }
+    CHECK(queue.TryPushBatch(none) == 0);
+    CHECK(queue.TryPopBatch(none) == 0);
+    CHECK(queue.SizeApprox() == queue.Capacity());
+}
+
+// Many laps around a small ring, single and batched, so every slot's index wraps
+template <typename Queue>
+void testWraparound() {
+    Queue queue(4);
+    uint64_t next_in = 0;
+    uint64_t next_out = 0;
+    uint64_t value = 0;
+    std::vector<uint64_t> buffer(3);
+    for (int lap = 0; lap < 1000; ++lap) {
+        CHECK(queue.TryPush(next_in++));
+        CHECK(queue.TryPush(next_in++));
+        CHECK(queue.TryPush(next_in++));
+        CHECK(queue.TryPop(value) && value == next_out++);
+        CHECK(queue.TryPop(value) && value == next_out++);
+
+        for (uint64_t& item : buffer) {
+            item = next_in++;
+        }
+        CHECK(queue.TryPushBatch(std::span<uint64_t>(buffer.data(), 3)) == 3);
+        CHECK(queue.TryPopBatch(std::span<uint64_t>(buffer)) == 3);
+        for (uint64_t item : buffer) {
+            CHECK(item == next_out++);
+        }
+        CHECK(queue.TryPop(value) && value == next_out++);
+        CHECK(!queue.TryPop(value));
+    }
+    CHECK(next_in == next_out);
+}
+
+// Every producer pushes 1..per_producer; consumers must see each value exactly as
+// often as it was pushed, so the count and the sum have to match
+template <typename Queue>
+void testThreaded(size_t producers, size_t consumers, size_t batch) {
+    constexpr size_t PER_PRODUCER = 50000;
+    Queue queue(256);
+    const size_t total = PER_PRODUCER * producers;
+    std::atomic<size_t> consumed{ 0 };
+    std::atomic<uint64_t> sum{ 0 };
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&]() {
+            std::vector<uint64_t> buffer(batch);
+            for (uint64_t i = 1; i <= PER_PRODUCER;) {
+                if (batch == 1) {
+                    if (queue.TryPush(i)) {
+                        ++i;
+                    }
+                    else {
+                        std::this_thread::yield();
+                    }
+                    continue;
+                }
+                const size_t n = std::min<size_t>(batch, PER_PRODUCER - i + 1);
+                for (size_t k = 0; k < n; ++k) {
+                    buffer[k] = i + k;
+                }
+                for (size_t pushed = 0; pushed < n;) {
+                    const size_t count = queue.TryPushBatch(std::span<uint64_t>(buffer.data() + pushed, n - pushed));
+                    pushed += count;
+                    if (count == 0) {
+                        std::this_thread::yield();
+                    }
+                }
+                i += n;
+            }
+        });
+    }
+    for (size_t c = 0; c < consumers; ++c) {
+        threads.emplace_back([&]() {
+            std::vector<uint64_t> buffer(batch);
+            uint64_t local_sum = 0;
+            while (consumed.load(std::memory_order_relaxed) < total) {
+                const size_t count = batch == 1
+                    ? (queue.TryPop(buffer[0]) ? 1 : 0)
+                    : queue.TryPopBatch(std::span<uint64_t>(buffer));
+                if (count == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (size_t k = 0; k < count; ++k) {
+                    local_sum += buffer[k];
+                }
+                consumed.fetch_add(count, std::memory_order_relaxed);
+            }
+            sum.fetch_add(local_sum, std::memory_order_relaxed);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    CHECK(consumed.load() == total);
+    CHECK(sum.load() == producers * (PER_PRODUCER * (PER_PRODUCER + 1) / 2));
+    CHECK(queue.SizeApprox() == 0);
+}
+
+template <typename Queue>
+void testQueue(const char* name, size_t producers, size_t consumers) {
+    const int failures_before = g_failures;
+    testSingleItem<Queue>();
+    testBatch<Queue>();
+    testEmptySpans<Queue>();
+    testWraparound<Queue>();
+    testThreaded<Queue>(producers, consumers, 1);
+    testThreaded<Queue>(producers, consumers, 16);
+    std::cout << (g_failures == failures_before ? "[PASS] " : "[FAIL] ") << name << "\n";
+}
+
+int main() {
+    testQueue<SpscRing<uint64_t>>("SpscRing", 1, 1);
+    testQueue<MpscRing<uint64_t>>("MpscRing", 4, 1);
+    testQueue<MpmcQueue<uint64_t>>("MpmcQueue", 4, 4);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -80,6 +80,32 @@ project "TestMod"
         optimize "on"
 
 
+-- Correctness tests for Spark's header-only containers; exits non-zero on failure
+project "SparkTests"
+    location "SparkTests"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("obj/" .. outputdir .. "/%{prj.name}")
+
+    files {
+        "SparkTests/src/**.cpp"
+    }
+
+    includedirs {
+        "Spark/include"
+    }
+
+    filter "configurations:Debug"
+        runtime "Debug"
+        symbols "on"
+
+    filter "configurations:Release"
+        runtime "Release"
+        optimize "on"
+
 -- Main Application Project
 project "Arcnum"
     location "Arcnum"